@@ -2,6 +2,13 @@
 
 
 #include "BSP_FloorGenerator.h"
+#include "DungeonAsync.h"
+#include "CA_FloorGenerator.h"
+#include "DungeonCollisionComponent.h"
+#include "DungeonStats.h"
+#include "DungeonMemory.h"
+#include "Async/ParallelFor.h"
+#include "Components/InstancedStaticMeshComponent.h"
 #include "Engine/World.h"
 #include "Engine/StaticMeshActor.h"
 #include "Kismet/KismetMathLibrary.h"
@@ -11,41 +18,255 @@
 // Sets default values
 ABSP_FloorGenerator::ABSP_FloorGenerator()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = false;
+	CollisionComponent = CreateDefaultSubobject<UDungeonCollisionComponent>(TEXT("Collision"));
+	RootComponent = CollisionComponent;
 
+	//Visuals only, all collision is on CollisionComponent
+	FloorInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("FloorInstances"));
+	FloorInstances->SetupAttachment(RootComponent);
+	FloorInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	WallInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("WallInstances"));
+	WallInstances->SetupAttachment(RootComponent);
+	WallInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+}
+
+FBSPLayoutSettings ABSP_FloorGenerator::MakeLayoutSettings() const
+{
+	FBSPLayoutSettings Settings;
+	Settings.MapSize = MapSize;
+	Settings.MinLeafSize = MinLeafSize;
+	Settings.MaxDepth = MaxDepth;
+	Settings.RoomPaddingMin = RoomPaddingMin;
+	Settings.RoomPaddingMax = RoomPaddingMax;
+	Settings.bConnectRooms = bConnectRooms;
+	Settings.bParallelSplit = bParallelSplit;
+	Settings.bCaveRooms = bCaveRooms;
+	Settings.CaveWallChance = CaveWallChance;
+	Settings.CaveSimulationSteps = CaveSimulationSteps;
+	Settings.CaveBirthLimit = CaveBirthLimit;
+	Settings.CaveDeathLimit = CaveDeathLimit;
+	Settings.ParallelDepth = ParallelDepth;
+	Settings.Seed = DungeonGrid::ResolveSeed(Seed);
+	return Settings;
 }
 
-// Called when the game starts or when spawned
-void ABSP_FloorGenerator::BeginPlay()
+void ABSP_FloorGenerator::GenerateLayout()
 {
-	Super::BeginPlay();
+	FBSPLayoutBuilder Builder(MakeLayoutSettings());
+	Builder.GenerateBSP();
 
-	GenerateBSP();
+	LeafRegions = MoveTemp(Builder.LeafRegions);
+	Tree = MoveTemp(Builder.Tree);
+	Layout = MoveTemp(Builder.Grid);
+}
 
-	SpawnFloorPlanes();
-	
+void ABSP_FloorGenerator::GenerateLayoutInBackground(TUniqueFunction<void(FDungeonGrid&&)>&& OnBuilt)
+{
+	DungeonAsync::LaunchLayoutTask(this,
+		[Builder = FBSPLayoutBuilder(MakeLayoutSettings())]() mutable
+		{
+			Builder.GenerateBSP();
+			return MoveTemp(Builder);
+		},
+		[this, OnBuilt = MoveTemp(OnBuilt)](FBSPLayoutBuilder&& Result)
+		{
+			LeafRegions = MoveTemp(Result.LeafRegions);
+			Tree = MoveTemp(Result.Tree);
+			OnBuilt(MoveTemp(Result.Grid));
+		});
 }
 
-void ABSP_FloorGenerator::GenerateBSP()
+void FBSPLayoutBuilder::GenerateBSP()
 {
+	DUNGEON_LLM_SCOPE(Grid);
+	const double StartTime = FPlatformTime::Seconds();
+
 	LeafRegions.Empty();
+	LeafNodes.Empty();
+	RoomAnchors.Empty();
+	Tree.Nodes.Empty();
+	Grid.Init(Settings.MapSize.X, Settings.MapSize.Y, false);
+	Grid.Seed = Settings.Seed;
+	INC_DWORD_STAT_BY(STAT_Dungeon_CellsProcessed, Settings.MapSize.X * Settings.MapSize.Y);
+
+	FRandomStream Rng(Settings.Seed);
+
+	//A full binary tree of MaxDepth has at most 2^(MaxDepth+1)-1 nodes
+	const int32 MaxNodes = (1 << FMath::Clamp(Settings.MaxDepth + 1, 1, 16)) - 1;
+	Tree.Nodes.Reserve(MaxNodes);
+
+	FBSPNode& Root = Tree.Nodes.AddDefaulted_GetRef();
+	Root.Region = FBSPLeaf(FIntPoint(0, 0), Settings.MapSize);
+	Root.PathHash = static_cast<uint32>(Settings.Seed);
+
+	{
+		DUNGEON_SCOPE(SplitSpace);
+
+		if (Settings.bParallelSplit)
+		{
+			SplitSpaceParallel();
+		}
+		else
+		{
+			SplitSubtree(Tree.Nodes, 0, MAX_int32, &Rng, nullptr);
+		}
+	}
+
+	CollectLeaves();
+
+	PlaceRooms(Rng);
+
+	if (Settings.bCaveRooms)
+	{
+		FillRoomsWithCaves();
+	}
+
+	if (Settings.bConnectRooms)
+	{
+		ConnectRooms(Rng);
+	}
+
+	Grid.BuildStats.NoteTempBytes(Tree.Nodes.GetAllocatedSize() + LeafNodes.GetAllocatedSize() + RoomAnchors.GetAllocatedSize());
+	Grid.BuildStats.BuildMs = (float)((FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+void FBSPLayoutBuilder::SplitSpaceParallel()
+{
+	//Top of the tree on this thread, stopping at ParallelDepth
+	TArray<int32> SubtreeRoots;
+	SplitSubtree(Tree.Nodes, 0, FMath::Max(0, Settings.ParallelDepth), nullptr, &SubtreeRoots);
+
+	//Each subtree grows in its own arena, seeded only by its own node paths
+	TArray<TArray<FBSPNode>> Subtrees;
+	Subtrees.SetNum(SubtreeRoots.Num());
+
+	ParallelFor(SubtreeRoots.Num(), [this, &Subtrees, &SubtreeRoots](int32 i)
+	{
+		TArray<FBSPNode>& Local = Subtrees[i];
+		FBSPNode& LocalRoot = Local.Add_GetRef(Tree.Nodes[SubtreeRoots[i]]);
+		LocalRoot.Parent = INDEX_NONE;
+
+		SplitSubtree(Local, 0, MAX_int32, nullptr, nullptr);
+	});
+
+	//Splice back in SubtreeRoots order, so the arena is the same for any thread count.
+	//Local node 0 is the subtree root already in the arena, the rest get appended
+	for (int32 i = 0; i < Subtrees.Num(); ++i)
+	{
+		const TArray<FBSPNode>& Local = Subtrees[i];
+		const int32 RootIndex = SubtreeRoots[i];
+		const int32 Base = Tree.Nodes.Num() - 1;
+
+		auto Remap = [RootIndex, Base](int32 LocalIndex)
+		{
+			return LocalIndex == INDEX_NONE ? INDEX_NONE : LocalIndex == 0 ? RootIndex : Base + LocalIndex;
+		};
+
+		Tree.Nodes[RootIndex].Children[0] = Remap(Local[0].Children[0]);
+		Tree.Nodes[RootIndex].Children[1] = Remap(Local[0].Children[1]);
+
+		for (int32 j = 1; j < Local.Num(); ++j)
+		{
+			FBSPNode& Node = Tree.Nodes.Add_GetRef(Local[j]);
+			Node.Parent = Remap(Node.Parent);
+			Node.Children[0] = Remap(Node.Children[0]);
+			Node.Children[1] = Remap(Node.Children[1]);
+		}
+	}
+}
+
+void FBSPLayoutBuilder::SplitSubtree(TArray<FBSPNode>& Nodes, int32 RootIndex, int32 StopDepth, FRandomStream* SharedRng, TArray<int32>* OutStopped) const
+{
+	TArray<int32, TInlineAllocator<32>> Stack;
+	Stack.Push(RootIndex);
+
+	while (Stack.Num() > 0)
+	{
+		const int32 NodeIndex = Stack.Pop();
+
+		//Copy out, adding children below may reallocate the arena
+		const FBSPLeaf Region = Nodes[NodeIndex].Region;
+		const int32 Depth = Nodes[NodeIndex].Depth;
+		const uint32 PathHash = Nodes[NodeIndex].PathHash;
+
+		if (Depth >= StopDepth)
+		{
+			if (OutStopped) OutStopped->Add(NodeIndex);
+			continue;
+		}
+
+		FRandomStream NodeRng(static_cast<int32>(PathHash));
+		FRandomStream& Rng = SharedRng ? *SharedRng : NodeRng;
+
+		FBSPLeaf First;
+		FBSPLeaf Second;
+		if (!TrySplit(Region, Depth, Rng, First, Second))
+		{
+			continue;
+		}
+
+		const int32 FirstIndex = Nodes.Num();
+		const int32 SecondIndex = FirstIndex + 1;
+
+		FBSPNode& FirstNode = Nodes.AddDefaulted_GetRef();
+		FirstNode.Region = First;
+		FirstNode.Parent = NodeIndex;
+		FirstNode.Depth = Depth + 1;
+		FirstNode.PathHash = HashCombine(PathHash, 1);
+
+		FBSPNode& SecondNode = Nodes.AddDefaulted_GetRef();
+		SecondNode.Region = Second;
+		SecondNode.Parent = NodeIndex;
+		SecondNode.Depth = Depth + 1;
+		SecondNode.PathHash = HashCombine(PathHash, 2);
+
+		Nodes[NodeIndex].Children[0] = FirstIndex;
+		Nodes[NodeIndex].Children[1] = SecondIndex;
+
+		//Second pushed first so the first child is split first, same order as the old recursion
+		Stack.Push(SecondIndex);
+		Stack.Push(FirstIndex);
+	}
+}
+
+void FBSPLayoutBuilder::CollectLeaves()
+{
+	if (Tree.IsEmpty()) return;
+
+	TArray<int32, TInlineAllocator<32>> Stack;
+	Stack.Push(0);
+
+	//Depth-first, first child first, independent of arena layout
+	while (Stack.Num() > 0)
+	{
+		const int32 NodeIndex = Stack.Pop();
+		const FBSPNode& Node = Tree.Nodes[NodeIndex];
 
-	FBSPLeaf Root(FIntPoint(0, 0), MapSize);
-	SplitSpace(Root, 0);
+		if (Node.IsLeaf())
+		{
+			LeafRegions.Add(Node.Region);
+			LeafNodes.Add(NodeIndex);
+			continue;
+		}
 
+		Stack.Push(Node.Children[1]);
+		Stack.Push(Node.Children[0]);
+	}
 }
 
-void ABSP_FloorGenerator::SplitSpace(const FBSPLeaf& Region, int32 Depth)
+bool FBSPLayoutBuilder::TrySplit(const FBSPLeaf& Region, int32 Depth, FRandomStream& Rng, FBSPLeaf& OutFirst, FBSPLeaf& OutSecond) const
 {
+	const int32 MinLeafSize = Settings.MinLeafSize;
+
 	const int32 Width = Region.Width();
 	const int32 Height = Region.Height();
 
 	//Stop if too small or depth reached
-	if (Depth >= MaxDepth || Width <= MinLeafSize * 2 && Height <= MinLeafSize * 2)
+	if (Depth >= Settings.MaxDepth || Width <= MinLeafSize * 2 && Height <= MinLeafSize * 2)
 	{
-		LeafRegions.Add(Region);
-		return;
+		return false;
 	}
 
 	//Decide whether to split vertically or horizontally
@@ -63,7 +284,7 @@ void ABSP_FloorGenerator::SplitSpace(const FBSPLeaf& Region, int32 Depth)
 	else
 	{
 		//50/50 when equal
-		bSplitVertically = FMath::RandBool();
+		bSplitVertically = Rng.FRand() < 0.5f;
 	}
 
 	//If the chosen axis is too small to split, try another axis
@@ -80,8 +301,7 @@ void ABSP_FloorGenerator::SplitSpace(const FBSPLeaf& Region, int32 Depth)
 	if (bSplitVertically && Width < MinLeafSize * 2 ||
 	!bSplitVertically && Height < MinLeafSize * 2)
 	{
-		LeafRegions.Add(Region);
-		return;
+		return false;
 	}
 
 	if (bSplitVertically)
@@ -92,17 +312,14 @@ void ABSP_FloorGenerator::SplitSpace(const FBSPLeaf& Region, int32 Depth)
 
 		if (SplitMin >= SplitMax)
 		{
-			LeafRegions.Add(Region);
-			return;
+			return false;
 		}
 
-		const int32 SplitX = FMath::RandRange(SplitMin, SplitMax);
+		const int32 SplitX = Rng.RandRange(SplitMin, SplitMax);
 
-		FBSPLeaf Left(FIntPoint(Region.Min.X, Region.Min.Y), FIntPoint(SplitX, Region.Max.Y));
-		FBSPLeaf Right(FIntPoint(SplitX, Region.Min.Y), FIntPoint(Region.Max.X, Region.Max.Y));
-
-		SplitSpace(Left, Depth + 1);
-		SplitSpace(Right, Depth + 1);
+		//Left, Right
+		OutFirst = FBSPLeaf(FIntPoint(Region.Min.X, Region.Min.Y), FIntPoint(SplitX, Region.Max.Y));
+		OutSecond = FBSPLeaf(FIntPoint(SplitX, Region.Min.Y), FIntPoint(Region.Max.X, Region.Max.Y));
 	}
 	else
 	{
@@ -112,39 +329,27 @@ void ABSP_FloorGenerator::SplitSpace(const FBSPLeaf& Region, int32 Depth)
 
 		if (SplitMin >= SplitMax)
 		{
-			LeafRegions.Add(Region);
-			return;
+			return false;
 		}
 
-		const int32 SplitY = FMath::RandRange(SplitMin, SplitMax);
-
-		FBSPLeaf Bottom(FIntPoint(Region.Min.X, Region.Min.Y), FIntPoint(Region.Max.X, SplitY));
-		FBSPLeaf Top(FIntPoint(Region.Min.X, SplitY), FIntPoint(Region.Max.X, Region.Max.Y));
+		const int32 SplitY = Rng.RandRange(SplitMin, SplitMax);
 
-		SplitSpace(Bottom, Depth + 1);
-		SplitSpace(Top, Depth + 1);
+		//Bottom, Top
+		OutFirst = FBSPLeaf(FIntPoint(Region.Min.X, Region.Min.Y), FIntPoint(Region.Max.X, SplitY));
+		OutSecond = FBSPLeaf(FIntPoint(Region.Min.X, SplitY), FIntPoint(Region.Max.X, Region.Max.Y));
 	}
+
+	return true;
 }
 
-void ABSP_FloorGenerator::SpawnFloorPlanes()
+void FBSPLayoutBuilder::PlaceRooms(FRandomStream& Rng)
 {
-	if (!FloorMesh)
-	{
-		UE_LOG(LogTemp, Warning, TEXT("BSP_FloorGenerator: FloorMesh is null"));
-		return;
-	}
+	DUNGEON_SCOPE(PlaceRooms);
 
-	UWorld* World = GetWorld();
-	if (!World)
+	for (const int32 NodeIndex : LeafNodes)
 	{
-		return;
-	}
+		const FBSPLeaf& Leaf = Tree.Nodes[NodeIndex].Region;
 
-	//Assume the plane and cube meshes are 100x100 units. Adjust if need be
-	const float BaseMeshSize = 100.f;
-
-	for (const FBSPLeaf& Leaf : LeafRegions)
-	{
 		const int32 LeafW = Leaf.Width();
 		const int32 LeafH = Leaf.Height();
 
@@ -154,13 +359,13 @@ void ABSP_FloorGenerator::SpawnFloorPlanes()
 		}
 
 		//Random padding inside the leaf so rooms don't fill entire region
-		const int32 PadMin = RoomPaddingMin;
-		const int32 PadMax = RoomPaddingMax;
+		const int32 PadMin = Settings.RoomPaddingMin;
+		const int32 PadMax = Settings.RoomPaddingMax;
 
-		int32 PadLeft = FMath::RandRange(PadMin, PadMax);
-		int32 PadRight = FMath::RandRange(PadMin, PadMax);
-		int32 PadBottom = FMath::RandRange(PadMin, PadMax);
-		int32 PadTop = FMath::RandRange(PadMin, PadMax);
+		int32 PadLeft = Rng.RandRange(PadMin, PadMax);
+		int32 PadRight = Rng.RandRange(PadMin, PadMax);
+		int32 PadBottom = Rng.RandRange(PadMin, PadMax);
+		int32 PadTop = Rng.RandRange(PadMin, PadMax);
 
 		//Clamp padding so room doesn't invert
 		PadLeft = FMath::Clamp(PadLeft, 0, LeafW - 1);
@@ -181,178 +386,535 @@ void ABSP_FloorGenerator::SpawnFloorPlanes()
 			continue;
 		}
 
-		const float RoomWorldWidth = RoomW * TileSize;
-		const float RoomWorldHeight = RoomH * TileSize;
+		const FIntRect Room(RoomMinX, RoomMinY, RoomMaxX, RoomMaxY);
+		Tree.Nodes[NodeIndex].RoomIndex = Grid.Rooms.Add(Room);
+		RoomAnchors.Add(Room.Min + FIntPoint(RoomW / 2, RoomH / 2));
+
+		for (int32 y = Room.Min.Y; y < Room.Max.Y; ++y)
+		{
+			for (int32 x = Room.Min.X; x < Room.Max.X; ++x)
+			{
+				if (Grid.IsInBounds(x, y)) Grid.SetFloor(x, y, true);
+			}
+		}
+	}
+}
+
+void FBSPLayoutBuilder::FillRoomsWithCaves()
+{
+	DUNGEON_LLM_SCOPE(Temp);
+	DUNGEON_SCOPE(FillRoomsWithCaves);
 
-		//Center of this room in world space
-		const FVector RoomCenter(
-			(RoomMinX + RoomW * 0.5f) * TileSize,
-			(RoomMinY + RoomH * 0.5f) * TileSize,
-			FloorZ
-		);
+	const int32 NumRooms = Grid.Rooms.Num();
 
-		const FVector WorldLocation = GetActorLocation() + RoomCenter;
+	FMemMark Mark(FMemStack::Get());
 
-		//Scale so that a 100x100 plane becomes WorldWidth x WorldHeight
-		const FVector FloorScale(
-			RoomWorldWidth / BaseMeshSize,
-			RoomWorldHeight / BaseMeshSize,
-			1.f
-		);
+	//Leaf that owns each room, for its seed. Only read by the workers, so it can live on this thread's mem stack
+	TDungeonScratchArray<int32> RoomLeaves;
+	RoomLeaves.Init(INDEX_NONE, NumRooms);
+	for (const int32 NodeIndex : LeafNodes)
+	{
+		const int32 RoomIndex = Tree.Nodes[NodeIndex].RoomIndex;
+		if (RoomIndex != INDEX_NONE) RoomLeaves[RoomIndex] = NodeIndex;
+	}
 
-		//---- Floor ---- 
+	//One small automaton per room. Each only reads its own rect and seed, so they run independently
+	TArray<FDungeonGrid> Caves;
+	Caves.SetNum(NumRooms);
 
-		AStaticMeshActor* FloorActor = World->SpawnActor<AStaticMeshActor>(WorldLocation, FRotator::ZeroRotator);
-		if (!FloorActor) continue;
+	ParallelFor(NumRooms, [this, &Caves, &RoomLeaves](int32 i)
+	{
+		const FIntRect& Room = Grid.Rooms[i];
+
+		FCALayoutSettings CaveSettings;
+		CaveSettings.MapWidth = Room.Width();
+		CaveSettings.MapHeight = Room.Height();
+		CaveSettings.InitWallChance = Settings.CaveWallChance;
+		CaveSettings.SimulationSteps = Settings.CaveSimulationSteps;
+		CaveSettings.BirthLimit = Settings.CaveBirthLimit;
+		CaveSettings.DeathLimit = Settings.CaveDeathLimit;
+		CaveSettings.Seed = static_cast<int32>(HashCombine(Tree.Nodes[RoomLeaves[i]].PathHash, 3) & MAX_int32);
+
+		FCALayoutBuilder Cave(CaveSettings);
+		Cave.Build();
+		Caves[i] = MoveTemp(Cave.Grid);
+	});
+
+	//Upper bound, the automatons' scratch plus every finished cave held until stitched
+	int64 CaveBytes = Caves.GetAllocatedSize();
+	for (const FDungeonGrid& Cave : Caves)
+	{
+		CaveBytes += Cave.Cells.GetAllocatedSize() + Cave.BuildStats.PeakTempBytes;
+	}
+	Grid.BuildStats.NoteTempBytes(CaveBytes);
 
-		if (UStaticMeshComponent* MeshComp = FloorActor->GetStaticMeshComponent())
+	//Stitch back serially. Rooms never overlap, so the order doesn't matter
+	for (int32 i = 0; i < NumRooms; ++i)
+	{
+		const FIntRect& Room = Grid.Rooms[i];
+		const FDungeonGrid& Cave = Caves[i];
+		const FIntPoint Center = RoomAnchors[i];
+
+		int32 BestDistSq = MAX_int32;
+		for (int32 y = 0; y < Cave.Height; ++y)
 		{
-			MeshComp->SetStaticMesh(FloorMesh);
-			FloorActor->SetActorScale3D(FloorScale);
-			FloorActor->SetMobility(EComponentMobility::Static);
+			for (int32 x = 0; x < Cave.Width; ++x)
+			{
+				const FIntPoint Cell(Room.Min.X + x, Room.Min.Y + y);
+				const bool bFloor = Cave.IsFloor(x, y);
+				Grid.SetFloor(Cell.X, Cell.Y, bFloor);
+
+				//Corridors connect to the cave floor closest to the room center
+				const int32 DistSq = (Cell - Center).SizeSquared();
+				if (bFloor && DistSq < BestDistSq)
+				{
+					BestDistSq = DistSq;
+					RoomAnchors[i] = Cell;
+				}
+			}
 		}
-		else
+
+		//Room too small for a cave, keep a single open cell so corridors have somewhere to end
+		if (BestDistSq == MAX_int32)
 		{
-			FloorActor->Destroy();
-			continue;
+			Grid.SetFloor(Center.X, Center.Y, true);
 		}
+	}
+}
 
-		//---- Walls ----
+void FBSPLayoutBuilder::ConnectRooms(FRandomStream& Rng)
+{
+	DUNGEON_LLM_SCOPE(Temp);
+	DUNGEON_SCOPE(ConnectRooms);
 
-		if (!WallMesh) continue;
+	const int32 NumNodes = Tree.Nodes.Num();
 
-		//Bottom Wall
-		{
+	FMemMark Mark(FMemStack::Get());
 
-			const FVector LocalPos(
-				(RoomMinX + RoomW * 0.5f) * TileSize,
-				RoomMinY * TileSize,
-				FloorZ + WallHeight * 0.f
-			);
-			const FVector WorldPos = GetActorLocation() + LocalPos;
+	//Room that stands in for each subtree when its parent gets connected
+	TDungeonScratchArray<int32> Representative;
+	Representative.Init(INDEX_NONE, NumNodes);
 
-			AStaticMeshActor* Wall = World->SpawnActor<AStaticMeshActor>(WorldPos, FRotator::ZeroRotator);
-				if (Wall)
-				{
-					if (UStaticMeshComponent* WComp = Wall->GetStaticMeshComponent())
-					{
-						WComp->SetStaticMesh(WallMesh);
-
-						const float ScaleX = RoomWorldWidth / BaseMeshSize;
-						const float ScaleY = WallThickness / BaseMeshSize;
-						const float ScaleZ = WallHeight / BaseMeshSize;
-
-						Wall->SetActorScale3D(FVector(ScaleX, ScaleY, ScaleZ));
-						Wall->SetMobility(EComponentMobility::Static);
-					}
-					else
-					{
-						Wall->Destroy();
-					}
-				}
+	TDungeonScratchArray<bool> CorridorMask;
+	CorridorMask.Init(false, Grid.Cells.Num());
+
+	//Children always come after their parent in the arena, so going backwards is bottom-up
+	for (int32 NodeIndex = NumNodes - 1; NodeIndex >= 0; --NodeIndex)
+	{
+		const FBSPNode& Node = Tree.Nodes[NodeIndex];
+		if (Node.IsLeaf())
+		{
+			Representative[NodeIndex] = Node.RoomIndex;
+			continue;
 		}
 
-		//Top Wall
+		const int32 RoomA = Representative[Node.Children[0]];
+		const int32 RoomB = Representative[Node.Children[1]];
+
+		//A leaf too small for a room leaves its side empty, nothing to connect
+		if (RoomA == INDEX_NONE || RoomB == INDEX_NONE)
 		{
-			const FVector LocalPos(
-				(RoomMinX + RoomW * 0.5f) * TileSize,
-				RoomMaxY * TileSize,
-				FloorZ + WallHeight * 0.f
-			);
-			const FVector WorldPos = GetActorLocation() + LocalPos;
+			Representative[NodeIndex] = RoomA != INDEX_NONE ? RoomA : RoomB;
+			continue;
+		}
 
-			AStaticMeshActor* Wall = World->SpawnActor<AStaticMeshActor>(WorldPos, FRotator::ZeroRotator);
-			if (!Wall) continue;
+		CarveCorridor(RoomAnchors[RoomA], RoomAnchors[RoomB], Rng.FRand() < 0.5f, CorridorMask);
 
-			if (UStaticMeshComponent* WComp = Wall->GetStaticMeshComponent())
-			{
-				WComp->SetStaticMesh(WallMesh);
+		Representative[NodeIndex] = Rng.FRand() < 0.5f ? RoomA : RoomB;
+	}
 
-				const float ScaleX = RoomWorldWidth / BaseMeshSize;
-				const float ScaleY = WallThickness / BaseMeshSize;
-				const float ScaleZ = WallHeight / BaseMeshSize;
+	//Only the newly carved cells, room floor is already covered by Rooms
+	DungeonGrid::MergeCellsIntoRects(CorridorMask, Grid.Width, Grid.Height, FIntRect(0, 0, Grid.Width, Grid.Height), Grid.Corridors);
 
-				Wall->SetActorScale3D(FVector(ScaleX, ScaleY, ScaleZ));
-				Wall->SetMobility(EComponentMobility::Static);
-			}
-			else
+	for (const bool bCorridor : CorridorMask)
+	{
+		if (bCorridor) ++Grid.BuildStats.CorridorCells;
+	}
+	Grid.BuildStats.NoteTempBytes(CorridorMask.GetAllocatedSize() + Representative.GetAllocatedSize());
+}
+
+void FBSPLayoutBuilder::CarveCorridor(const FIntPoint& From, const FIntPoint& To, bool bHorizontalFirst, TDungeonScratchArray<bool>& CorridorMask)
+{
+	INC_DWORD_STAT(STAT_Dungeon_CorridorsCarved);
+
+	auto CarveLine = [this, &CorridorMask](const FIntPoint& A, const FIntPoint& B)
+	{
+		for (int32 y = FMath::Min(A.Y, B.Y); y <= FMath::Max(A.Y, B.Y); ++y)
+		{
+			for (int32 x = FMath::Min(A.X, B.X); x <= FMath::Max(A.X, B.X); ++x)
 			{
-				Wall->Destroy();
+				//Cells already inside a room stay room floor
+				if (!Grid.IsInBounds(x, y) || Grid.IsFloor(x, y)) continue;
+
+				Grid.SetFloor(x, y, true);
+				CorridorMask[Grid.Index(x, y)] = true;
 			}
+		}
+	};
+
+	const FIntPoint Corner = bHorizontalFirst ? FIntPoint(To.X, From.Y) : FIntPoint(From.X, To.Y);
+	CarveLine(From, Corner);
+	CarveLine(Corner, To);
+}
+
+int32 FBSPTree::FindLeafAt(const FIntPoint& Cell) const
+{
+	if (Nodes.Num() == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	const FIntRect RootRect(Nodes[0].Region.Min, Nodes[0].Region.Max);
+	if (!RootRect.Contains(Cell))
+	{
+		return INDEX_NONE;
+	}
+
+	//Children split their parent exactly, so the cell is always in one of them
+	int32 NodeIndex = 0;
+	while (!Nodes[NodeIndex].IsLeaf())
+	{
+		const FBSPNode& First = Nodes[Nodes[NodeIndex].Children[0]];
+		const bool bInFirst = Cell.X < First.Region.Max.X && Cell.Y < First.Region.Max.Y;
+		NodeIndex = Nodes[NodeIndex].Children[bInFirst ? 0 : 1];
+	}
+
+	return NodeIndex;
+}
+
+void FBSPTree::FindLeavesOverlapping(const FIntRect& Rect, TArray<int32>& OutLeaves) const
+{
+	if (Nodes.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<int32, TInlineAllocator<32>> Stack;
+	Stack.Push(0);
 
+	while (Stack.Num() > 0)
+	{
+		const int32 NodeIndex = Stack.Pop();
+		const FBSPNode& Node = Nodes[NodeIndex];
+		const FIntRect NodeRect(Node.Region.Min, Node.Region.Max);
+		if (!NodeRect.Intersect(Rect))
+		{
+			continue;
 		}
 
-		//Left Wall
+		if (Node.IsLeaf())
 		{
-			const FVector LocalPos(
-				RoomMinX  * TileSize,
-				(RoomMinY + RoomH * 0.5f) * TileSize,
-				FloorZ + WallHeight * 0.f
-			);
-			const FVector WorldPos = GetActorLocation() + LocalPos;
+			OutLeaves.Add(NodeIndex);
+			continue;
+		}
 
-			//Yaw 90 so mesh's x-axis points along world y
-			const FRotator Rot(0.f, 90.f, 0.f);
+		Stack.Push(Node.Children[1]);
+		Stack.Push(Node.Children[0]);
+	}
+}
 
-			AStaticMeshActor* Wall = World->SpawnActor<AStaticMeshActor>(WorldPos, Rot);
+int32 FBSPTree::GetSibling(int32 NodeIndex) const
+{
+	if (!Nodes.IsValidIndex(NodeIndex) || Nodes[NodeIndex].Parent == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
 
-			if (!Wall) continue;
+	const FBSPNode& Parent = Nodes[Nodes[NodeIndex].Parent];
+	return Parent.Children[0] == NodeIndex ? Parent.Children[1] : Parent.Children[0];
+}
 
-			if (UStaticMeshComponent* WComp = Wall->GetStaticMeshComponent())
-			{
-				WComp->SetStaticMesh(WallMesh);
+FIntPoint ABSP_FloorGenerator::WorldToCell(const FVector& WorldLocation) const
+{
+	const FVector Local = WorldLocation - GetActorLocation();
+	return FIntPoint(
+		FMath::FloorToInt(Local.X / TileSize),
+		FMath::FloorToInt(Local.Y / TileSize)
+	);
+}
 
-				const float ScaleX = RoomWorldHeight / BaseMeshSize;
-				const float ScaleY = WallThickness / BaseMeshSize;
-				const float ScaleZ = WallHeight / BaseMeshSize;
+int32 ABSP_FloorGenerator::FindRoomAt(const FVector& WorldLocation) const
+{
+	const FIntPoint Cell = WorldToCell(WorldLocation);
 
-				Wall->SetActorScale3D(FVector(ScaleX, ScaleY, ScaleZ));
-				Wall->SetMobility(EComponentMobility::Static);
-			}
-			else
-			{
-				Wall->Destroy();
-			}
+	const int32 Leaf = Tree.FindLeafAt(Cell);
+	if (Leaf == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	//The leaf also holds the padding around its room
+	const int32 RoomIndex = Tree.Nodes[Leaf].RoomIndex;
+	if (RoomIndex == INDEX_NONE || !Layout.Rooms.IsValidIndex(RoomIndex) || !Layout.Rooms[RoomIndex].Contains(Cell))
+	{
+		return INDEX_NONE;
+	}
+
+	return RoomIndex;
+}
+
+TArray<int32> ABSP_FloorGenerator::FindRoomsInArea(const FVector& WorldMin, const FVector& WorldMax) const
+{
+	const FIntPoint A = WorldToCell(WorldMin);
+	const FIntPoint B = WorldToCell(WorldMax);
+	const FIntRect Rect(
+		FMath::Min(A.X, B.X), FMath::Min(A.Y, B.Y),
+		FMath::Max(A.X, B.X) + 1, FMath::Max(A.Y, B.Y) + 1
+	);
+
+	TArray<int32> Leaves;
+	Tree.FindLeavesOverlapping(Rect, Leaves);
+
+	TArray<int32> Result;
+	for (const int32 Leaf : Leaves)
+	{
+		const int32 RoomIndex = Tree.Nodes[Leaf].RoomIndex;
+		if (RoomIndex != INDEX_NONE && Layout.Rooms.IsValidIndex(RoomIndex) && Layout.Rooms[RoomIndex].Intersect(Rect))
+		{
+			Result.Add(RoomIndex);
 		}
+	}
+	return Result;
+}
+
+TArray<int32> ABSP_FloorGenerator::GetSiblingRooms(int32 RoomIndex) const
+{
+	TArray<int32> Result;
+	if (!Layout.Rooms.IsValidIndex(RoomIndex))
+	{
+		return Result;
+	}
+
+	const int32 Leaf = Tree.FindLeafAt(Layout.Rooms[RoomIndex].Min);
+	const int32 Sibling = Tree.GetSibling(Leaf);
+	if (Sibling == INDEX_NONE)
+	{
+		return Result;
+	}
+
+	const FBSPLeaf& Region = Tree.Nodes[Sibling].Region;
+	TArray<int32> Leaves;
+	Tree.FindLeavesOverlapping(FIntRect(Region.Min, Region.Max), Leaves);
 
-		//Right Wall
+	for (const int32 Other : Leaves)
+	{
+		if (Tree.Nodes[Other].RoomIndex != INDEX_NONE)
 		{
-			const FVector LocalPos(
-				RoomMaxX * TileSize,
-				(RoomMinY + RoomH * 0.5f) * TileSize,
-				FloorZ + WallHeight * 0.f
-			);
-			const FVector WorldPos = GetActorLocation() + LocalPos;
+			Result.Add(Tree.Nodes[Other].RoomIndex);
+		}
+	}
+	return Result;
+}
 
-			const FRotator Rot(0.f, 90.f, 0.f);
+void ABSP_FloorGenerator::SpawnGeometry()
+{
+	DUNGEON_SCOPE(SpawnGeometry);
+	const double SpawnStart = FPlatformTime::Seconds();
 
-			AStaticMeshActor* Wall = World->SpawnActor<AStaticMeshActor>(WorldPos, Rot);
-			if(!Wall) continue;
+	UpdateGenerationDescriptor();
 
-			if (UStaticMeshComponent* WComp = Wall->GetStaticMeshComponent())
-			{
-				WComp->SetStaticMesh(WallMesh);
+	if (!FloorMesh)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("BSP_FloorGenerator: FloorMesh is null"));
+		return;
+	}
 
-				const float ScaleX = RoomWorldHeight / BaseMeshSize;
-				const float ScaleY = WallThickness / BaseMeshSize;
-				const float ScaleZ = WallHeight / BaseMeshSize;
+	if (!GetWorld())
+	{
+		return;
+	}
 
-				Wall->SetActorScale3D(FVector(ScaleX, ScaleY, ScaleZ));
-				Wall->SetMobility(EComponentMobility::Static);
-			}
-			else
-			{
-				Wall->Destroy();
-			}
-		}
+	//From the cells rather than Rooms / Corridors, which only match the floor when rooms aren't caves.
+	//A replicated or baked layout is drawn right whatever this actor's bCaveRooms says
+	TArray<FIntRect> FloorRects;
+	Layout.BuildFloorRects(FloorRects);
+
+	TArray<FDungeonWallSpan> Spans;
+	if (WallMesh)
+	{
+		Layout.BuildWallSpans(Spans);
+	}
+
+	ActorPool.BeginReuse();
 
+	if (bMergeCollision)
+	{
+		ActorPool.EndReuse();
+		BuildMergedGeometry(FloorRects, Spans);
+		RecordTelemetry(SpawnStart);
+		return;
+	}
+
+	//Instances and the collision body of an earlier merged pass would stay under the actors
+	FloorInstances->ClearInstances();
+	WallInstances->ClearInstances();
+	if (CollisionComponent->GetNumBoxes() > 0)
+	{
+		CollisionComponent->ClearBoxes();
+	}
+
+	//One static mesh actor per rect / span, spawned in one batch per mesh
+	TArray<FTransform> FloorTransforms;
+	TArray<FTransform> WallTransforms;
+	FloorTransforms.Reserve(FloorRects.Num());
+	WallTransforms.Reserve(Spans.Num());
+
+	for (const FIntRect& Rect : FloorRects)
+	{
+		FloorTransforms.Add(ToWorld(GetFloorRectTransform(Rect)));
+	}
+
+	for (const FDungeonWallSpan& Span : Spans)
+	{
+		WallTransforms.Add(ToWorld(GetWallSpanTransform(Span)));
 	}
+
+	ActorPool.AcquireBatch(GetWorld(), FloorMesh, FloorTransforms);
+	ActorPool.AcquireBatch(GetWorld(), WallMesh, WallTransforms);
+
+	ActorPool.EndReuse();
+
+	RecordTelemetry(SpawnStart);
+}
+
+FTransform ABSP_FloorGenerator::GetFloorRectTransform(const FIntRect& Rect) const
+{
+	//Assume the plane and cube meshes are 100x100 units. Adjust if need be
+	const float BaseMeshSize = 100.f;
+
+	const int32 RectW = Rect.Width();
+	const int32 RectH = Rect.Height();
+
+	//Center of this rect relative to the generator
+	const FVector Center(
+		(Rect.Min.X + RectW * 0.5f) * TileSize,
+		(Rect.Min.Y + RectH * 0.5f) * TileSize,
+		FloorZ
+	);
+
+	//Scale so that a 100x100 plane becomes WorldWidth x WorldHeight
+	const FVector FloorScale(
+		RectW * TileSize / BaseMeshSize,
+		RectH * TileSize / BaseMeshSize,
+		1.f
+	);
+
+	return FTransform(FRotator::ZeroRotator, Center, FloorScale);
 }
 
-// Called every frame
-void ABSP_FloorGenerator::Tick(float DeltaTime)
+FTransform ABSP_FloorGenerator::GetWallSpanTransform(const FDungeonWallSpan& Span) const
 {
-	Super::Tick(DeltaTime);
+	const float BaseMeshSize = 100.f;
+
+	//Spans along X sit on a horizontal line, spans along Y get Yaw 90 so mesh's x-axis points along world y
+	const FVector LocalPos = Span.bAlongX
+		? FVector((Span.Start.X + Span.Length * 0.5f) * TileSize, Span.Start.Y * TileSize, FloorZ)
+		: FVector(Span.Start.X * TileSize, (Span.Start.Y + Span.Length * 0.5f) * TileSize, FloorZ);
+	const FRotator Rot(0.f, Span.bAlongX ? 0.f : 90.f, 0.f);
 
+	const float ScaleX = Span.Length * TileSize / BaseMeshSize;
+	const float ScaleY = WallThickness / BaseMeshSize;
+	const float ScaleZ = WallHeight / BaseMeshSize;
+
+	return FTransform(Rot, LocalPos, FVector(ScaleX, ScaleY, ScaleZ));
+}
+
+FTransform ABSP_FloorGenerator::ToWorld(const FTransform& Local) const
+{
+	return Local * GetActorTransform();
 }
 
+void ABSP_FloorGenerator::BuildMergedGeometry(const TArray<FIntRect>& FloorRects, const TArray<FDungeonWallSpan>& Spans)
+{
+	DUNGEON_LLM_SCOPE(Actors);
+
+	TArray<FTransform> FloorTransforms;
+	TArray<FTransform> WallTransforms;
+	TArray<FBox> Boxes;
+
+	FloorTransforms.Reserve(FloorRects.Num());
+	WallTransforms.Reserve(Spans.Num());
+	Boxes.Reserve(FloorRects.Num() + Spans.Num());
+
+	//---- Floor ----
+
+	for (const FIntRect& Rect : FloorRects)
+	{
+		FloorTransforms.Add(GetFloorRectTransform(Rect));
+
+		//Thin slab with its top at FloorZ
+		const FVector Min(Rect.Min.X * TileSize, Rect.Min.Y * TileSize, FloorZ - FloorCollisionThickness);
+		const FVector Max(Rect.Max.X * TileSize, Rect.Max.Y * TileSize, FloorZ);
+		Boxes.Add(FBox(Min, Max));
+	}
+
+	//---- Walls ----
+
+	for (const FDungeonWallSpan& Span : Spans)
+	{
+		const FTransform Local = GetWallSpanTransform(Span);
+		WallTransforms.Add(Local);
+
+		//Same box the scaled cube covers, spans are axis aligned so no rotation needed
+		const float Length = Span.Length * TileSize;
+		const FVector HalfSize = Span.bAlongX
+			? FVector(Length, WallThickness, WallHeight) * 0.5f
+			: FVector(WallThickness, Length, WallHeight) * 0.5f;
+		Boxes.Add(FBox(Local.GetLocation() - HalfSize, Local.GetLocation() + HalfSize));
+	}
+
+	FloorInstances->ClearInstances();
+	FloorInstances->SetStaticMesh(FloorMesh);
+	FloorInstances->AddInstances(FloorTransforms, false);
+
+	WallInstances->ClearInstances();
+	WallInstances->SetStaticMesh(WallMesh);
+	WallInstances->AddInstances(WallTransforms, false);
+
+	CollisionComponent->SetBoxes(Boxes);
+
+	UE_LOG(LogTemp, Log, TEXT("BSP_FloorGenerator: %d floor rects, %d wall spans, %d collision boxes in one body"),
+		FloorRects.Num(), Spans.Num(), CollisionComponent->GetNumBoxes());
+}
+
+FDungeonSeedSearchResult ABSP_FloorGenerator::SearchSeeds(const FDungeonSeedConstraints& Constraints, int32 NumSeeds, int32 NumBest, int32 FirstSeed) const
+{
+	//bParallelSplit stays as configured, the split mode changes which layout a seed produces
+	return DungeonSeedSearch::SearchBuilder(GetGeneratorName(), MakeLayoutSettings(), &FBSPLayoutBuilder::GenerateBSP, FirstSeed, NumSeeds, NumBest, Constraints);
+}
+
+void ABSP_FloorGenerator::UpdateGenerationDescriptor()
+{
+	DungeonReplication::UpdateDescriptor(this, bReplicateGeneration, GetGeneratorName(), MakeLayoutSettings(), Layout, GenerationDescriptor);
+}
+
+void ABSP_FloorGenerator::ApplyGenerationDescriptor()
+{
+	FBSPLayoutSettings Settings;
+	if (!DungeonReplication::ReadSettings(GenerationDescriptor, GetGeneratorName(), Settings)) return;
+
+	DungeonReplication::BuildFromDescriptor(this, GenerationDescriptor, Settings, &FBSPLayoutBuilder::GenerateBSP, bGenerateAsync, OnLayoutReady,
+		[this](FBSPLayoutBuilder& Builder)
+		{
+			LeafRegions = MoveTemp(Builder.LeafRegions);
+			Tree = MoveTemp(Builder.Tree);
+			SpawnLayout(Builder.Grid);
+		});
+}
+
+void ABSP_FloorGenerator::AddTelemetryDetails(FDungeonGenerationTelemetry& Telemetry) const
+{
+	Telemetry.Parameters = FString::Printf(TEXT("MinLeafSize=%d MaxDepth=%d ConnectRooms=%d CaveRooms=%d ParallelSplit=%d MergeCollision=%d"),
+		MinLeafSize, MaxDepth, bConnectRooms ? 1 : 0, bCaveRooms ? 1 : 0, bParallelSplit ? 1 : 0, bMergeCollision ? 1 : 0);
+	if (bMergeCollision)
+	{
+		Telemetry.Instances = FloorInstances->GetInstanceCount() + WallInstances->GetInstanceCount();
+	}
+}
+
+void ABSP_FloorGenerator::GetMemoryUsage(FDungeonMemoryUsage& Out) const
+{
+	Super::GetMemoryUsage(Out);
+	Out.GridBytes += LeafRegions.GetAllocatedSize() + Tree.Nodes.GetAllocatedSize();
+	Out.Instances += FloorInstances->GetInstanceCount() + WallInstances->GetInstanceCount();
+}
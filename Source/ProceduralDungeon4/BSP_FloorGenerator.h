@@ -3,9 +3,12 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
+#include "DungeonFloorGeneratorBase.h"
 #include "BSP_FloorGenerator.generated.h"
 
+class UDungeonCollisionComponent;
+class UInstancedStaticMeshComponent;
+
 USTRUCT(BlueprintType)
 struct FBSPLeaf
 {
@@ -30,8 +33,151 @@ struct FBSPLeaf
 	int32 Height() const { return Max.Y - Min.Y; }
 };
 
+//Node of an FBSPTree. Children are indices into the same node array
+struct FBSPNode
+{
+	FBSPLeaf Region;
+
+	int32 Parent = INDEX_NONE;
+	int32 Children[2] = { INDEX_NONE, INDEX_NONE };
+	int32 Depth = 0;
+
+	//Index into FDungeonGrid::Rooms for leaves that got a room
+	int32 RoomIndex = INDEX_NONE;
+
+	//Hash of the seed and the child slots taken from the root. Seeds this node's own stream
+	//when splitting in parallel, so a subtree doesn't depend on what was split before it
+	uint32 PathHash = 0;
+
+	bool IsLeaf() const { return Children[0] == INDEX_NONE; }
+};
+
+//Full BSP tree kept in one contiguous node arena, root at index 0.
+//Children always come after their parent, so walking the array backwards visits the tree bottom-up
+struct PROCEDURALDUNGEON4_API FBSPTree
+{
+	TArray<FBSPNode> Nodes;
+
+	//Leaf containing Cell, or INDEX_NONE if Cell is outside the map. O(depth)
+	int32 FindLeafAt(const FIntPoint& Cell) const;
+
+	//Every leaf whose region overlaps Rect (max edges exclusive). O(depth + results)
+	void FindLeavesOverlapping(const FIntRect& Rect, TArray<int32>& OutLeaves) const;
+
+	//The other child of NodeIndex's parent, INDEX_NONE for the root
+	int32 GetSibling(int32 NodeIndex) const;
+
+	bool IsEmpty() const { return Nodes.Num() == 0; }
+};
+
+//Parameters of the logical phase, copied out of the actor before generation
+USTRUCT(BlueprintType)
+struct FBSPLayoutSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "BSP")
+	FIntPoint MapSize = FIntPoint(40, 40);
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "BSP")
+	int32 MinLeafSize = 8;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "BSP")
+	int32 MaxDepth = 5;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "BSP|Parallel")
+	bool bParallelSplit = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "BSP|Parallel")
+	int32 ParallelDepth = 3;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "BSP|Rooms")
+	int32 RoomPaddingMin = 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "BSP|Rooms")
+	int32 RoomPaddingMax = 3;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "BSP|Corridors")
+	bool bConnectRooms = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "BSP|Caves")
+	bool bCaveRooms = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "BSP|Caves")
+	int32 CaveWallChance = 45;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "BSP|Caves")
+	int32 CaveSimulationSteps = 4;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "BSP|Caves")
+	int32 CaveBirthLimit = 4;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "BSP|Caves")
+	int32 CaveDeathLimit = 3;
+
+	//Already resolved, never negative
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "BSP")
+	int32 Seed = 0;
+};
+
+//Logical phase of ABSP_FloorGenerator. Touches no UObjects, so it is safe to run on a worker thread
+struct FBSPLayoutBuilder
+{
+	explicit FBSPLayoutBuilder(const FBSPLayoutSettings& InSettings)
+		: Settings(InSettings)
+	{}
+
+	//Splits the map, places one room per leaf and connects sibling subtrees
+	void GenerateBSP();
+
+	FBSPLayoutSettings Settings;
+
+	//All leaf regions after BSP split
+	TArray<FBSPLeaf> LeafRegions;
+
+	//The whole split, kept for spatial queries
+	FBSPTree Tree;
+
+	//Room cells marked as floor, room rectangles in Grid.Rooms
+	FDungeonGrid Grid;
+
+private:
+	//Split the top ParallelDepth levels here, then every remaining subtree as its own task
+	void SplitSpaceParallel();
+
+	//Split Nodes[RootIndex] iteratively with an explicit stack, depth-first and first child first.
+	//Draws from SharedRng if given, otherwise from a stream per node seeded by its PathHash.
+	//Nodes at StopDepth are left unsplit and added to OutStopped
+	void SplitSubtree(TArray<FBSPNode>& Nodes, int32 RootIndex, int32 StopDepth, FRandomStream* SharedRng, TArray<int32>* OutStopped) const;
+
+	//Fill LeafRegions / LeafNodes in depth-first order
+	void CollectLeaves();
+
+	//Leaf node indices in the order LeafRegions was filled
+	TArray<int32> LeafNodes;
+
+	//Cell each room's corridors start from, per room: the center, or the cave floor closest to it
+	TArray<FIntPoint> RoomAnchors;
+
+	//Decide how Region splits. False if it should stay a leaf
+	bool TrySplit(const FBSPLeaf& Region, int32 Depth, FRandomStream& Rng, FBSPLeaf& OutFirst, FBSPLeaf& OutSecond) const;
+
+	//Shrink each leaf by a random padding and rasterize the result into Grid
+	void PlaceRooms(FRandomStream& Rng);
+
+	//Replace each room rectangle with a cave from its own FCALayoutBuilder, all rooms in parallel
+	void FillRoomsWithCaves();
+
+	//Walk the tree bottom-up and join the two children of every split with one corridor.
+	//One corridor per internal node, so the rooms end up connected with no distance searches
+	void ConnectRooms(FRandomStream& Rng);
+
+	//Carve an L-shaped corridor between two cells, marking newly opened cells in CorridorMask
+	void CarveCorridor(const FIntPoint& From, const FIntPoint& To, bool bHorizontalFirst, TDungeonScratchArray<bool>& CorridorMask);
+};
+
 UCLASS()
-class PROCEDURALDUNGEON4_API ABSP_FloorGenerator : public AActor
+class PROCEDURALDUNGEON4_API ABSP_FloorGenerator : public ADungeonFloorGeneratorBase
 {
 	GENERATED_BODY()
 	
@@ -39,10 +185,9 @@ public:
 	// Sets default values for this actor's properties
 	ABSP_FloorGenerator();
 
-protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
+	virtual void GetMemoryUsage(FDungeonMemoryUsage& Out) const override;
 
+protected:
 	//Size of the whole map in grid cells
 	UPROPERTY(EditAnywhere, Category = "BSP")
 	FIntPoint MapSize = FIntPoint(40, 40);
@@ -55,14 +200,20 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "BSP")
 	int32 MaxDepth = 5;
 
+	//Split subtrees below ParallelDepth as independent tasks. Every node draws from its own stream
+	//seeded by its path from the root, so the layout is the same for any thread count
+	//(but differs from the serial split for the same seed)
+	UPROPERTY(EditAnywhere, Category = "BSP|Parallel")
+	bool bParallelSplit = false;
+
+	//Depth at which subtrees are handed to tasks, up to 2^ParallelDepth of them
+	UPROPERTY(EditAnywhere, Category = "BSP|Parallel", meta = (EditCondition = "bParallelSplit", ClampMin = "0"))
+	int32 ParallelDepth = 3;
+
 	//Size of one grid cell in world units (cm)
 	UPROPERTY(EditAnywhere, Category = "BSP")
 	float TileSize = 100.f;
 
-	//Plane mesh to use for each room floor
-	UPROPERTY(EditAnywhere, Category = "BSP")
-	UStaticMesh* FloorMesh;
-
 	//Z Offset for the floor
 	UPROPERTY(EditAnywhere, Category = "BSP")
 	float FloorZ = 0.f;
@@ -74,11 +225,31 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "BSP|Rooms")
 	int32 RoomPaddingMax = 3;
 
-	// ---- Walls ----
+	//Join sibling subtrees with corridors. Without it every room is a closed box
+	UPROPERTY(EditAnywhere, Category = "BSP|Corridors")
+	bool bConnectRooms = true;
 
-	//Mesh used for walls
-	UPROPERTY(EditAnywhere, Category = "BSP|Walls")
-	UStaticMesh* WallMesh;
+	// ---- Caves ----
+
+	//Fill each room with a cellular automaton cave instead of a flat floor.
+	//Every room runs its own small automaton in parallel, seeded from its leaf
+	UPROPERTY(EditAnywhere, Category = "BSP|Caves")
+	bool bCaveRooms = false;
+
+	//Same rules as ACA_FloorGenerator, applied per room
+	UPROPERTY(EditAnywhere, Category = "BSP|Caves", meta = (EditCondition = "bCaveRooms"))
+	int32 CaveWallChance = 45;
+
+	UPROPERTY(EditAnywhere, Category = "BSP|Caves", meta = (EditCondition = "bCaveRooms"))
+	int32 CaveSimulationSteps = 4;
+
+	UPROPERTY(EditAnywhere, Category = "BSP|Caves", meta = (EditCondition = "bCaveRooms"))
+	int32 CaveBirthLimit = 4;
+
+	UPROPERTY(EditAnywhere, Category = "BSP|Caves", meta = (EditCondition = "bCaveRooms"))
+	int32 CaveDeathLimit = 3;
+
+	// ---- Walls ----
 	
 	//Height of walls
 	UPROPERTY(EditAnywhere, Category = "BSP|Walls")
@@ -88,6 +259,43 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "BSP|Walls")
 	float WallThickness = 50.f;
 
+	// ---- Collision ----
+
+	//Keep rooms and walls as rectangles all the way: draw them through two instanced meshes without
+	//collision and put one simple box per floor rect / wall span into a single body on CollisionComponent.
+	//Off = one static mesh actor with its own collision per rect and span
+	UPROPERTY(EditAnywhere, Category = "BSP|Collision")
+	bool bMergeCollision = true;
+
+	//Depth of the floor boxes below FloorZ
+	UPROPERTY(EditAnywhere, Category = "BSP|Collision", meta = (EditCondition = "bMergeCollision"))
+	float FloorCollisionThickness = 10.f;
+
+	UPROPERTY(VisibleAnywhere, Category = "Components")
+	TObjectPtr<UDungeonCollisionComponent> CollisionComponent;
+
+	UPROPERTY(VisibleAnywhere, Category = "Components")
+	TObjectPtr<UInstancedStaticMeshComponent> FloorInstances;
+
+	UPROPERTY(VisibleAnywhere, Category = "Components")
+	TObjectPtr<UInstancedStaticMeshComponent> WallInstances;
+
+	// ---- Builder hooks ----
+
+	virtual const TCHAR* GetGeneratorName() const override { return TEXT("BSP"); }
+
+	//Fills LeafRegions and Tree along with Layout
+	virtual void GenerateLayout() override;
+	virtual void GenerateLayoutInBackground(TUniqueFunction<void(FDungeonGrid&&)>&& OnBuilt) override;
+	virtual void UpdateGenerationDescriptor() override;
+	virtual void ApplyGenerationDescriptor() override;
+	virtual FDungeonSeedSearchResult SearchSeeds(const FDungeonSeedConstraints& Constraints, int32 NumSeeds, int32 NumBest, int32 FirstSeed) const override;
+
+	//Floors for the merged floor rects of the layout, walls along every merged floor boundary.
+	//Wall spans leave gaps where corridors enter rooms
+	virtual void SpawnGeometry() override;
+
+	virtual void AddTelemetryDetails(FDungeonGenerationTelemetry& Telemetry) const override;
 
 private:
 	//All leaf regions after BSP split
@@ -95,13 +303,40 @@ private:
 	UPROPERTY()
 	TArray<FBSPLeaf> LeafRegions;
 
-	void GenerateBSP();
-	void SplitSpace(const FBSPLeaf& Region, int32 Depth);
+	//Tree the current layout was split from
+	FBSPTree Tree;
+
+	//Snapshot of the config above with the seed resolved
+	FBSPLayoutSettings MakeLayoutSettings() const;
+
+	//Placement of the floor plane / wall cube relative to the generator
+	FTransform GetFloorRectTransform(const FIntRect& Rect) const;
+	FTransform GetWallSpanTransform(const FDungeonWallSpan& Span) const;
+
+	//Local placement through the generator's transform, for the per-actor path. Same space the merged path's components use
+	FTransform ToWorld(const FTransform& Local) const;
 
-	void SpawnFloorPlanes();
+	//bMergeCollision path: instances for the visuals, one box per rect / span in CollisionComponent
+	void BuildMergedGeometry(const TArray<FIntRect>& FloorRects, const TArray<FDungeonWallSpan>& Spans);
 
 public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	// ---- Queries ----
+
+	//Index of the room containing WorldLocation, -1 if it's not inside a room
+	UFUNCTION(BlueprintCallable, Category = "BSP")
+	int32 FindRoomAt(const FVector& WorldLocation) const;
+
+	//Indices of rooms whose leaf overlaps the world space box spanned by the two corners
+	UFUNCTION(BlueprintCallable, Category = "BSP")
+	TArray<int32> FindRoomsInArea(const FVector& WorldMin, const FVector& WorldMax) const;
+
+	//Rooms in the subtree on the other side of RoomIndex's last split
+	UFUNCTION(BlueprintCallable, Category = "BSP")
+	TArray<int32> GetSiblingRooms(int32 RoomIndex) const;
+
+	const FBSPTree& GetTree() const { return Tree; }
+
+private:
+	FIntPoint WorldToCell(const FVector& WorldLocation) const;
 
 };
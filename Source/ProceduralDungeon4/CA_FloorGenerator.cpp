@@ -2,38 +2,165 @@
 
 
 #include "CA_FloorGenerator.h"
+#include "DungeonAsync.h"
+#include "DungeonMeshing.h"
+#include "DungeonChunkStreamer.h"
+#include "DungeonStats.h"
+#include "DungeonMemory.h"
 #include "Engine/World.h"
 #include "Engine/StaticMeshActor.h"
 #include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+
+namespace
+{
+	//Integer hash of (seed, cell) with good avalanche, murmur3 finalizer style
+	uint32 HashCell(int32 Seed, int32 X, int32 Y)
+	{
+		uint32 H = static_cast<uint32>(Seed) * 0x9E3779B1u;
+		H ^= static_cast<uint32>(X) * 0x85EBCA77u;
+		H ^= static_cast<uint32>(Y) * 0xC2B2AE3Du;
+		H ^= H >> 16;
+		H *= 0x85EBCA6Bu;
+		H ^= H >> 13;
+		H *= 0xC2B2AE35u;
+		H ^= H >> 16;
+		return H;
+	}
+}
 
 // Sets default values
 ACA_FloorGenerator::ACA_FloorGenerator()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = false;
+	Root = CreateDefaultSubobject<USceneComponent>("Root");
+	SetRootComponent(Root);
+
+	ChunkStreamer = CreateDefaultSubobject<UDungeonChunkStreamer>("ChunkStreamer");
+
+}
+
+void ACA_FloorGenerator::GenerateAndSpawn(bool bAsync)
+{
+	if (bInfiniteChunks)
+	{
+		StartInfiniteStreaming(MakeLayoutSettings());
+		return;
+	}
+
+	Super::GenerateAndSpawn(bAsync);
+}
+
+FCALayoutSettings ACA_FloorGenerator::MakeLayoutSettings() const
+{
+	FCALayoutSettings Settings;
+	Settings.MapWidth = MapWidth;
+	Settings.MapHeight = MapHeight;
+	Settings.InitWallChance = InitWallChance;
+	Settings.SimulationSteps = SimulationSteps;
+	Settings.BirthLimit = BirthLimit;
+	Settings.DeathLimit = DeathLimit;
+	Settings.Seed = DungeonGrid::ResolveSeed(Seed);
+	return Settings;
+}
+
+void ACA_FloorGenerator::GenerateLayout()
+{
+	FCALayoutBuilder Builder(MakeLayoutSettings());
+	Builder.Build();
+	Layout = MoveTemp(Builder.Grid);
+}
 
+void ACA_FloorGenerator::GenerateLayoutInBackground(TUniqueFunction<void(FDungeonGrid&&)>&& OnBuilt)
+{
+	DungeonAsync::LaunchLayoutTask(this,
+		[Builder = FCALayoutBuilder(MakeLayoutSettings())]() mutable
+		{
+			Builder.Build();
+			return MoveTemp(Builder.Grid);
+		},
+		MoveTemp(OnBuilt));
 }
 
-// Called when the game starts or when spawned
-void ACA_FloorGenerator::BeginPlay()
+void FCALayoutBuilder::Build()
 {
-	Super::BeginPlay();
+	DUNGEON_LLM_SCOPE(Grid);
+	const double StartTime = FPlatformTime::Seconds();
+
+	const int32 MapWidth = Settings.MapWidth;
+	const int32 MapHeight = Settings.MapHeight;
+
+	Grid.Init(MapWidth, MapHeight, false);
+	Grid.Seed = Settings.Seed;
+	if (MapWidth <= 0 || MapHeight <= 0) return;
 
-	InitializeMap();
+	FRandomStream Rng(Settings.Seed);
+
+	InitializeMap(Rng);
 	RunSimulation();
 	EnsureConnectivity();
-	SpawnGeometry();
-	
+
+	//Flip to the shared convention: true = floor
+	for (int32 i = 0; i < CurrentMap.Num(); ++i)
+	{
+		Grid.Cells[i] = !CurrentMap[i];
+	}
+
+	Grid.BuildStats.BuildMs = (float)((FPlatformTime::Seconds() - StartTime) * 1000.0);
 }
 
-void ACA_FloorGenerator::Tick(float DeltaTime)
+void FCALayoutBuilder::BuildChunk(const FIntPoint& ChunkCoord, int32 ChunkSize)
 {
-    Super::Tick(DeltaTime);
-    // No per-frame logic needed for now
+	DUNGEON_LLM_SCOPE(Grid);
+
+	//Errors from the window edge creep in one cell per step, so a halo of SimulationSteps keeps the chunk exact
+	const int32 Halo = FMath::Max(0, Settings.SimulationSteps);
+	const int32 WindowSize = ChunkSize + Halo * 2;
+
+	Settings.MapWidth = WindowSize;
+	Settings.MapHeight = WindowSize;
+
+	Grid.Init(ChunkSize, ChunkSize, false);
+	Grid.Seed = Settings.Seed;
+	if (ChunkSize <= 0) return;
+
+	InitializeNoise(ChunkCoord * ChunkSize - FIntPoint(Halo, Halo));
+	RunSimulation();
+
+	//Crop the halo, flip to true = floor
+	for (int32 y = 0; y < ChunkSize; ++y)
+	{
+		for (int32 x = 0; x < ChunkSize; ++x)
+		{
+			Grid.SetFloor(x, y, !CurrentMap[Index(x + Halo, y + Halo)]);
+		}
+	}
 }
 
-void ACA_FloorGenerator::InitializeMap()
+void FCALayoutBuilder::InitializeNoise(const FIntPoint& Origin)
 {
+	DUNGEON_LLM_SCOPE(Temp);
+
+	const int32 NumCells = Settings.MapWidth * Settings.MapHeight;
+	CurrentMap.SetNum(NumCells);
+	NextMap.SetNum(NumCells);
+
+	for (int32 y = 0; y < Settings.MapHeight; ++y)
+	{
+		for (int32 x = 0; x < Settings.MapWidth; ++x)
+		{
+			//Same 0-100 roll as InitializeMap, but a pure function of the world cell
+			const uint32 Roll = HashCell(Settings.Seed, Origin.X + x, Origin.Y + y) % 101;
+			CurrentMap[Index(x, y)] = static_cast<int32>(Roll) < Settings.InitWallChance;
+		}
+	}
+}
+
+void FCALayoutBuilder::InitializeMap(FRandomStream& Rng)
+{
+	DUNGEON_LLM_SCOPE(Temp);
+
+	const int32 MapWidth = Settings.MapWidth;
+	const int32 MapHeight = Settings.MapHeight;
 	const int32 NumCells = MapWidth * MapHeight;
 	CurrentMap.SetNum(NumCells);
 	NextMap.SetNum(NumCells);
@@ -51,8 +178,8 @@ void ACA_FloorGenerator::InitializeMap()
 			}
 			else
 			{
-				const int32 Rand = FMath::RandRange(0, 100);
-				bIsWall = (Rand < InitWallChance);
+				const int32 Rand = Rng.RandRange(0, 100);
+				bIsWall = (Rand < Settings.InitWallChance);
 			}
 
 			CurrentMap[Index(x, y)] = bIsWall;
@@ -61,20 +188,28 @@ void ACA_FloorGenerator::InitializeMap()
 	}
 }
 
-void ACA_FloorGenerator::RunSimulation()
+void FCALayoutBuilder::RunSimulation()
 {
-	for(int32 i = 0; i < SimulationSteps; ++i)
+	DUNGEON_LLM_SCOPE(Temp);
+	DUNGEON_SCOPE(RunSimulation);
+	INC_DWORD_STAT_BY(STAT_Dungeon_CellsProcessed, Settings.MapWidth * Settings.MapHeight * FMath::Max(0, Settings.SimulationSteps));
+
+	for(int32 i = 0; i < Settings.SimulationSteps; ++i)
 	{
 		StepSimulation();
-		CurrentMap = NextMap;
+
+		//StepSimulation writes every cell of NextMap, so swapping is enough and skips a copy
+		Swap(CurrentMap, NextMap);
 	}
+
+	Grid.BuildStats.NoteTempBytes(CurrentMap.GetAllocatedSize() + NextMap.GetAllocatedSize());
 }
 
-void ACA_FloorGenerator::StepSimulation()
+void FCALayoutBuilder::StepSimulation()
 {
-	for (int32 y = 0; y < MapHeight; ++y)
+	for (int32 y = 0; y < Settings.MapHeight; ++y)
 	{
-		for(int32 x = 0; x < MapWidth; ++x)
+		for(int32 x = 0; x < Settings.MapWidth; ++x)
 		{
 			const int32 Neighbors = CountWallNeighbors(x, y);
 			const bool bCurrentWall = CurrentMap[Index(x, y)];
@@ -84,7 +219,7 @@ void ACA_FloorGenerator::StepSimulation()
 			if (bCurrentWall)
 			{
 				//Too few wall neighbors => becomes floor
-				if (Neighbors < DeathLimit)
+				if (Neighbors < Settings.DeathLimit)
 				{
 					bNewWall = false;
 				}
@@ -96,7 +231,7 @@ void ACA_FloorGenerator::StepSimulation()
 			else
 			{
 				//Emough wall neighbors => becomes wall
-				if (Neighbors > BirthLimit)
+				if (Neighbors > Settings.BirthLimit)
 				{
 					bNewWall = true;
 				}
@@ -111,8 +246,10 @@ void ACA_FloorGenerator::StepSimulation()
 	}
 }
 
-int32 ACA_FloorGenerator::CountWallNeighbors(int32 X, int32 Y) const
+int32 FCALayoutBuilder::CountWallNeighbors(int32 X, int32 Y) const
 {
+	const int32 MapWidth = Settings.MapWidth;
+	const int32 MapHeight = Settings.MapHeight;
 	int32 Count = 0;
 
 	for (int32 ny = Y - 1; ny <= Y + 1; ++ny)
@@ -142,6 +279,11 @@ int32 ACA_FloorGenerator::CountWallNeighbors(int32 X, int32 Y) const
 
 void ACA_FloorGenerator::SpawnGeometry()
 {
+	DUNGEON_SCOPE(SpawnGeometry);
+	const double SpawnStart = FPlatformTime::Seconds();
+
+	UpdateGenerationDescriptor();
+
 	UWorld* World = GetWorld();
 	if (!World) return;
 
@@ -150,35 +292,50 @@ void ACA_FloorGenerator::SpawnGeometry()
 		UE_LOG(LogTemp, Warning, TEXT("CA_FloorGenerator: FloorMesh is null"));
 	}
 
+	ActorPool.BeginReuse();
+
+	//Only one representation of the layout may be alive, drop the other one from an earlier pass
+	if (bStreamChunks)
+	{
+		ActorPool.EndReuse();
+		DungeonMeshing::DestroyChunks(FloorChunks);
+		StartStreaming();
+		RecordTelemetry(SpawnStart);
+		return;
+	}
+
+	ChunkStreamer->ClearLayout();
+
 	const float BasePlaneSize = 100.f;
 
-	for (int32 y = 0; y < MapHeight; ++y)
+	if (bMergeFloorMeshes && FloorMesh)
+	{
+		BuildMergedFloor();
+	}
+	else
+	{
+		//Chunks of an earlier merged pass would draw and collide under the per-cell planes
+		DungeonMeshing::DestroyChunks(FloorChunks);
+	}
+
+	//Gather first, then spawn each mesh in one batch
+	TArray<FTransform> FloorTransforms;
+	TArray<FTransform> WallTransforms;
+
+	for (int32 y = 0; y < Layout.Height; ++y)
 	{
-		for (int32 x = 0; x < MapWidth; ++x)
+		for (int32 x = 0; x < Layout.Width; ++x)
 		{
-			const bool bIsWall = CurrentMap[Index(x, y)];
+			const bool bIsWall = !Layout.IsFloor(x, y);
 
 			//Spawn floor wheere there is no wall
-			if (!bIsWall && FloorMesh)
+			if (!bIsWall && FloorMesh && !bMergeFloorMeshes)
 			{
 				const FVector WorldPos = GetActorLocation() + FVector(x * TileSize, y * TileSize, FloorZ);
 
-				AStaticMeshActor* FloorActor = World->SpawnActor<AStaticMeshActor>(WorldPos, FRotator::ZeroRotator);
-				if (!FloorActor) continue;
-
-				UStaticMeshComponent* MeshComp = FloorActor->GetStaticMeshComponent();
-				if (!MeshComp)
-				{
-					FloorActor->Destroy();
-					continue;
-				}
-
-				MeshComp->SetStaticMesh(FloorMesh);
-
 				//Center the tile
 				const float ScaleFactor = TileSize / BasePlaneSize;
-				FloorActor->SetActorScale3D(FVector(ScaleFactor, ScaleFactor, 1.f));
-				FloorActor->SetMobility(EComponentMobility::Static);
+				FloorTransforms.Add(FTransform(FRotator::ZeroRotator, WorldPos, FVector(ScaleFactor, ScaleFactor, 1.f)));
 			}
 
 			//Spawn wall mesh where there's a wall
@@ -186,40 +343,47 @@ void ACA_FloorGenerator::SpawnGeometry()
 			{
 				const FVector WallPos = GetActorLocation() + FVector(x * TileSize, y * TileSize, FloorZ);
 
-				AStaticMeshActor* WallActor = World->SpawnActor<AStaticMeshActor>(WallPos, FRotator::ZeroRotator);
-				if (!WallActor) continue;
-
-				UStaticMeshComponent* MeshComp = WallActor->GetStaticMeshComponent();
-				if (!MeshComp)
-				{
-					WallActor->Destroy();
-					continue;
-				}
-
-				MeshComp->SetStaticMesh(WallMesh);
-
 				//Assume WallMesh is 100x100x100 cube, scale to TileSize and WallHeight
 				const float XYScale = TileSize / BasePlaneSize;
 				const float ZScale = WallHeight / BasePlaneSize;
 
-				WallActor->SetActorScale3D(FVector(XYScale, XYScale, ZScale));
-				WallActor->SetMobility(EComponentMobility::Static);
+				WallTransforms.Add(FTransform(FRotator::ZeroRotator, WallPos, FVector(XYScale, XYScale, ZScale)));
 			}
 		}
 	}
+
+	ActorPool.AcquireBatch(World, FloorMesh, FloorTransforms);
+	ActorPool.AcquireBatch(World, WallMesh, WallTransforms);
+
+	ActorPool.EndReuse();
+
+	RecordTelemetry(SpawnStart);
 }
 
-void ACA_FloorGenerator::EnsureConnectivity()
+void FCALayoutBuilder::EnsureConnectivity()
 {
+	DUNGEON_LLM_SCOPE(Temp);
+	DUNGEON_SCOPE(EnsureConnectivity);
+
+	const int32 MapWidth = Settings.MapWidth;
+	const int32 MapHeight = Settings.MapHeight;
 	const int32 NumCells = MapWidth * MapHeight;
 	if (NumCells == 0) return;
 
+	//Everything below lives on the thread's mem stack and is dropped in one go on return
+	FMemMark Mark(FMemStack::Get());
+
 	//Label array: -1=unvisited, >=0=region id
-	TArray<int32> Labels;
+	TDungeonScratchArray<int32> Labels;
 	Labels.Init(-1, NumCells);
 
-	struct FRegionData { TArray<FIntPoint> Cells; };
-	TArray<FRegionData> Regions;
+	//Cells of every region back to back, region i is [RegionStarts[i], RegionStarts[i + 1])
+	TDungeonScratchArray<FIntPoint> RegionCells;
+	TDungeonScratchArray<int32> RegionStarts;
+	RegionCells.Reserve(NumCells);
+
+	//Flood fill stack, shared by every region
+	TDungeonScratchArray<FIntPoint> Stack;
 
 	int32 NextRegionId = 0;
 
@@ -234,23 +398,36 @@ void ACA_FloorGenerator::EnsureConnectivity()
 			//Already visited
 			if(Labels[Idx] != -1) continue;
 
-			Regions.AddDefaulted();
-			FRegionData& Region = Regions.Last();
-
-			FloodFillRegion(x, y, NextRegionId, Labels, Region.Cells);
+			RegionStarts.Add(RegionCells.Num());
+			FloodFillRegion(x, y, NextRegionId, Labels, RegionCells, Stack);
 			++NextRegionId;
 		}
 	}
 
+	const int32 NumRegions = RegionStarts.Num();
+	RegionStarts.Add(RegionCells.Num());
+
+	auto GetRegion = [&RegionCells, &RegionStarts](int32 Region)
+	{
+		return TConstArrayView<FIntPoint>(RegionCells.GetData() + RegionStarts[Region], RegionStarts[Region + 1] - RegionStarts[Region]);
+	};
+
+	INC_DWORD_STAT_BY(STAT_Dungeon_RegionsFound, NumRegions);
+
 	//If there are 0 or 1 regions, nothing to connect
-	if (Regions.Num() <= 1) return;
+	if (NumRegions <= 1)
+	{
+		Grid.BuildStats.NoteTempBytes(CurrentMap.GetAllocatedSize() + NextMap.GetAllocatedSize() + Labels.GetAllocatedSize()
+			+ RegionCells.GetAllocatedSize() + RegionStarts.GetAllocatedSize() + Stack.GetAllocatedSize());
+		return;
+	}
 
 	//Choose the largest region as the main one
 	int32 MainRegionIndex = 0;
-	int32 MaxSize = Regions[0].Cells.Num();
-	for (int32 i = 1; i < Regions.Num(); ++i)
+	int32 MaxSize = GetRegion(0).Num();
+	for (int32 i = 1; i < NumRegions; ++i)
 	{
-		const int32 Size = Regions[i].Cells.Num();
+		const int32 Size = GetRegion(i).Num();
 		if (Size > MaxSize)
 		{
 			MaxSize = Size;
@@ -258,15 +435,21 @@ void ACA_FloorGenerator::EnsureConnectivity()
 		}
 	}
 
-	//Grow the set as other regions are connected
-	TArray<FIntPoint> MainCells = Regions[MainRegionIndex].Cells;
+	//Grow the set as other regions are connected. Can't get bigger than every floor cell, so it never reallocates
+	TDungeonScratchArray<FIntPoint> MainCells;
+	MainCells.Reserve(RegionCells.Num());
+	MainCells.Append(GetRegion(MainRegionIndex));
+
+	//Both maps, labels, region cells and the main set are alive at this point
+	Grid.BuildStats.NoteTempBytes(CurrentMap.GetAllocatedSize() + NextMap.GetAllocatedSize() + Labels.GetAllocatedSize()
+		+ RegionCells.GetAllocatedSize() + RegionStarts.GetAllocatedSize() + Stack.GetAllocatedSize() + MainCells.GetAllocatedSize());
 
 	//Connect all other regions into the main region
-	for (int32 i = 0; i < Regions.Num(); ++i)
+	for (int32 i = 0; i < NumRegions; ++i)
 	{
 		if (i == MainRegionIndex) continue;
 
-		const TArray<FIntPoint>& OtherCells = Regions[i].Cells;
+		const TConstArrayView<FIntPoint> OtherCells = GetRegion(i);
 
 		FIntPoint MainCell;
 		FIntPoint OtherCell;
@@ -281,10 +464,13 @@ void ACA_FloorGenerator::EnsureConnectivity()
 	}
 }
 
-void ACA_FloorGenerator::FloodFillRegion(int32 StartX, int32 StartY, int32 RegionId, TArray<int32>& OutLabels, TArray<FIntPoint>& OutCells) const
+void FCALayoutBuilder::FloodFillRegion(int32 StartX, int32 StartY, int32 RegionId, TDungeonScratchArray<int32>& OutLabels,
+	TDungeonScratchArray<FIntPoint>& OutCells, TDungeonScratchArray<FIntPoint>& Stack) const
 {
-	TArray<FIntPoint> Stack;
-	Stack.Reserve(128);
+	const int32 MapWidth = Settings.MapWidth;
+	const int32 MapHeight = Settings.MapHeight;
+
+	Stack.Reset();
 	Stack.Add(FIntPoint(StartX, StartY));
 
 	while (Stack.Num() > 0)
@@ -310,7 +496,7 @@ void ACA_FloorGenerator::FloodFillRegion(int32 StartX, int32 StartY, int32 Regio
 }
 
 //Returns the minimum Manhattan distance or -1 if no pair found
-int32 ACA_FloorGenerator::FindClosestPairBetweenRegions(const TArray<FIntPoint>& RegionA, const TArray<FIntPoint>& RegionB, FIntPoint& OutA, FIntPoint& OutB) const
+int32 FCALayoutBuilder::FindClosestPairBetweenRegions(TConstArrayView<FIntPoint> RegionA, TConstArrayView<FIntPoint> RegionB, FIntPoint& OutA, FIntPoint& OutB) const
 {
 	int32 BestDist = TNumericLimits<int32>::Max();
 	bool bFound = false;
@@ -333,8 +519,10 @@ int32 ACA_FloorGenerator::FindClosestPairBetweenRegions(const TArray<FIntPoint>&
 	return bFound ? BestDist : -1;
 }
 
-void ACA_FloorGenerator::CarveCorridorBetween(const FIntPoint& A, const FIntPoint& B)
+void FCALayoutBuilder::CarveCorridorBetween(const FIntPoint& A, const FIntPoint& B)
 {
+	INC_DWORD_STAT(STAT_Dungeon_CorridorsCarved);
+
 	FIntPoint Current = A;
 
 	//First walk in X, then in Y for a simple L-shaped corridor
@@ -345,6 +533,7 @@ void ACA_FloorGenerator::CarveCorridorBetween(const FIntPoint& A, const FIntPoin
 	{
 		const int32 Idx = Index(Current.X, Current.Y);
 		//Floor
+		if (CurrentMap[Idx]) ++Grid.BuildStats.CorridorCells;
 		CurrentMap[Idx] = false;
 
 		Current.X += StepX;
@@ -354,6 +543,7 @@ void ACA_FloorGenerator::CarveCorridorBetween(const FIntPoint& A, const FIntPoin
 	{
 		const int32 Idx = Index(Current.X, Current.Y);
 		//Floor
+		if (CurrentMap[Idx]) ++Grid.BuildStats.CorridorCells;
 		CurrentMap[Idx] = false;
 
 		Current.Y += StepY;
@@ -361,5 +551,129 @@ void ACA_FloorGenerator::CarveCorridorBetween(const FIntPoint& A, const FIntPoin
 
 	//Make sure the destination cell is also Floor
 	const int32 EndIdx = Index(B.X, B.Y);
+	if (CurrentMap[EndIdx]) ++Grid.BuildStats.CorridorCells;
 	CurrentMap[EndIdx] = false;
-}
\ No newline at end of file
+}
+
+void ACA_FloorGenerator::BuildMergedFloor()
+{
+	DUNGEON_LLM_SCOPE(Actors);
+	DUNGEON_SCOPE(BuildMergedFloor);
+
+	//Cells are centered on their coordinates, so cell (0,0) starts half a tile back
+	const FVector CellOrigin(-TileSize * 0.5f, -TileSize * 0.5f, FloorZ);
+
+	DungeonMeshing::BuildFloorChunks(this, Root, Layout, FloorChunkSize, TileSize, CellOrigin,
+		FloorMesh ? FloorMesh->GetMaterial(0) : nullptr, FloorChunks);
+}
+
+void ACA_FloorGenerator::StartStreaming()
+{
+	const FVector CellOrigin(-TileSize * 0.5f, -TileSize * 0.5f, FloorZ);
+
+	ChunkStreamer->SetLayout(Layout, Root, TileSize, CellOrigin,
+		FloorMesh ? FloorMesh->GetMaterial(0) : nullptr, WallMesh,
+		[this](const FDungeonGrid& Grid, const FIntRect& CellRect, const FIntPoint& CellOffset, TArray<FTransform>& OutTransforms)
+		{
+			GatherWallTransforms(Grid, CellRect, CellOffset, OutTransforms);
+		});
+}
+
+void ACA_FloorGenerator::GatherWallTransforms(const FDungeonGrid& Grid, const FIntRect& CellRect, const FIntPoint& CellOffset, TArray<FTransform>& OutTransforms) const
+{
+	const float BasePlaneSize = 100.f;
+	const FVector WallScale(TileSize / BasePlaneSize, TileSize / BasePlaneSize, WallHeight / BasePlaneSize);
+
+	for (int32 y = CellRect.Min.Y; y < CellRect.Max.Y; ++y)
+	{
+		for (int32 x = CellRect.Min.X; x < CellRect.Max.X; ++x)
+		{
+			if (Grid.IsFloor(x, y)) continue;
+
+			const FIntPoint Cell = CellOffset + FIntPoint(x, y);
+			OutTransforms.Add(FTransform(FRotator::ZeroRotator, FVector(Cell.X * TileSize, Cell.Y * TileSize, FloorZ), WallScale));
+		}
+	}
+}
+
+void ACA_FloorGenerator::StartInfiniteStreaming(const FCALayoutSettings& Settings)
+{
+	//Chunks are a pure function of seed and settings, clients stream the same cave from the descriptor alone
+	if (bReplicateGeneration && HasAuthority())
+	{
+		GenerationDescriptor = DungeonReplication::MakeDescriptor(GetGeneratorName(), Settings, nullptr);
+	}
+
+	//Actors and merged chunks of an earlier finite layout would stay visible under the cave, e.g. after Regenerate
+	ActorPool.BeginReuse();
+	ActorPool.EndReuse();
+	DungeonMeshing::DestroyChunks(FloorChunks);
+
+	const int32 ChunkSize = ChunkStreamer->ChunkSize;
+	const FVector CellOrigin(-TileSize * 0.5f, -TileSize * 0.5f, FloorZ);
+
+	ChunkStreamer->SetChunkProvider(
+		[Settings, ChunkSize](const FIntPoint& Chunk)
+		{
+			FCALayoutBuilder Builder(Settings);
+			Builder.BuildChunk(Chunk, ChunkSize);
+			return MoveTemp(Builder.Grid);
+		},
+		Root, TileSize, CellOrigin,
+		FloorMesh ? FloorMesh->GetMaterial(0) : nullptr, WallMesh,
+		[this](const FDungeonGrid& Grid, const FIntRect& CellRect, const FIntPoint& CellOffset, TArray<FTransform>& OutTransforms)
+		{
+			GatherWallTransforms(Grid, CellRect, CellOffset, OutTransforms);
+		});
+
+	UE_LOG(LogTemp, Log, TEXT("CA_FloorGenerator: streaming infinite cave, seed %d, %d cell chunks"), Settings.Seed, ChunkSize);
+}
+
+bool ACA_FloorGenerator::PrepareBake()
+{
+	//Streamed geometry lives in pooled components that come and go with the player
+	if (bStreamChunks || bInfiniteChunks)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("CA_FloorGenerator: streamed layouts can't be baked, turn off bStreamChunks and bInfiniteChunks"));
+		return false;
+	}
+
+	//Merged chunks are procedural meshes, which can't hold lightmaps. Bake per-cell floor actors instead
+	bMergeFloorMeshes = false;
+	return true;
+}
+
+FDungeonSeedSearchResult ACA_FloorGenerator::SearchSeeds(const FDungeonSeedConstraints& Constraints, int32 NumSeeds, int32 NumBest, int32 FirstSeed) const
+{
+	return DungeonSeedSearch::SearchBuilder(GetGeneratorName(), MakeLayoutSettings(), &FCALayoutBuilder::Build, FirstSeed, NumSeeds, NumBest, Constraints);
+}
+
+void ACA_FloorGenerator::UpdateGenerationDescriptor()
+{
+	DungeonReplication::UpdateDescriptor(this, bReplicateGeneration, GetGeneratorName(), MakeLayoutSettings(), Layout, GenerationDescriptor);
+}
+
+void ACA_FloorGenerator::ApplyGenerationDescriptor()
+{
+	FCALayoutSettings Settings;
+	if (!DungeonReplication::ReadSettings(GenerationDescriptor, GetGeneratorName(), Settings)) return;
+
+	if (bInfiniteChunks)
+	{
+		StartInfiniteStreaming(Settings);
+		return;
+	}
+
+	DungeonReplication::BuildFromDescriptor(this, GenerationDescriptor, Settings, &FCALayoutBuilder::Build, bGenerateAsync, OnLayoutReady,
+		[this](FCALayoutBuilder& Builder)
+		{
+			SpawnLayout(Builder.Grid);
+		});
+}
+
+void ACA_FloorGenerator::AddTelemetryDetails(FDungeonGenerationTelemetry& Telemetry) const
+{
+	Telemetry.Parameters = FString::Printf(TEXT("InitWallChance=%d SimulationSteps=%d BirthLimit=%d DeathLimit=%d"),
+		InitWallChance, SimulationSteps, BirthLimit, DeathLimit);
+	Telemetry.MeshChunks = FloorChunks.Num();
+}
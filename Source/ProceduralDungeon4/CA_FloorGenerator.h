@@ -3,11 +3,90 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
+#include "DungeonFloorGeneratorBase.h"
 #include "CA_FloorGenerator.generated.h"
 
+class UProceduralMeshComponent;
+class UDungeonChunkStreamer;
+
+//Parameters of the logical phase, copied out of the actor before generation
+USTRUCT(BlueprintType)
+struct FCALayoutSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CA")
+	int32 MapWidth = 60;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CA")
+	int32 MapHeight = 40;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CA")
+	int32 InitWallChance = 45;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CA")
+	int32 SimulationSteps = 5;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CA")
+	int32 BirthLimit = 4;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CA")
+	int32 DeathLimit = 3;
+
+	//Already resolved, never negative
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "CA")
+	int32 Seed = 0;
+};
+
+//Logical phase of ACA_FloorGenerator. Touches no UObjects, so it is safe to run on a worker thread
+struct FCALayoutBuilder
+{
+	explicit FCALayoutBuilder(const FCALayoutSettings& InSettings)
+		: Settings(InSettings)
+	{}
+
+	//Runs the whole pipeline and fills Grid
+	void Build();
+
+	//Infinite mode: fill Grid with the ChunkSize x ChunkSize cells of chunk ChunkCoord.
+	//Initial noise is hashed from (seed, world cell) and the automaton runs over a SimulationSteps wide halo,
+	//so two chunks agree on every cell they share at the seam. No closed border and no connectivity pass,
+	//both would depend on where the chunk boundary is
+	void BuildChunk(const FIntPoint& ChunkCoord, int32 ChunkSize);
+
+	FCALayoutSettings Settings;
+
+	//Result - true = floor, false = wall
+	FDungeonGrid Grid;
+
+private:
+	//Grid: true = wall, false = floor
+	TArray<bool> CurrentMap;
+	TArray<bool> NextMap;
+
+	FORCEINLINE int32 Index(int32 X, int32 Y) const
+	{
+		return Y * Settings.MapWidth + X;
+	}
+
+	void InitializeMap(FRandomStream& Rng);
+
+	//Noise for the MapWidth x MapHeight window starting at world cell Origin
+	void InitializeNoise(const FIntPoint& Origin);
+	void RunSimulation();
+	void StepSimulation();
+	int32 CountWallNeighbors(int32 X, int32 Y) const;
+
+	//----Connectivity----
+	void EnsureConnectivity();
+	void FloodFillRegion(int32 StartX, int32 StartY, int32 RegionId, TDungeonScratchArray<int32>& OutLabels,
+		TDungeonScratchArray<FIntPoint>& OutCells, TDungeonScratchArray<FIntPoint>& Stack) const;
+	int32 FindClosestPairBetweenRegions(TConstArrayView<FIntPoint> RegionA, TConstArrayView<FIntPoint> RegionB, FIntPoint& OutA, FIntPoint& OutB) const;
+	void CarveCorridorBetween(const FIntPoint& A, const FIntPoint& B);
+};
+
 UCLASS()
-class PROCEDURALDUNGEON4_API ACA_FloorGenerator : public AActor
+class PROCEDURALDUNGEON4_API ACA_FloorGenerator : public ADungeonFloorGeneratorBase
 {
 	GENERATED_BODY()
 	
@@ -16,9 +95,6 @@ public:
 	ACA_FloorGenerator();
 
 protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-
 	// ---- Grid / CA Settings ----
 
 	//Grid size in cells
@@ -48,14 +124,6 @@ protected:
 	//Size of each cell in world units (cm)
 	UPROPERTY(EditAnywhere, Category = "CA")
 	float TileSize = 100.f;
-
-	//Mesh used for each floor tile
-	UPROPERTY(EditAnywhere, Category = "CA")
-	UStaticMesh* FloorMesh;
-	
-	//Mesh used for walls
-	UPROPERTY(EditAnywhere, Category = "CA")
-	UStaticMesh* WallMesh;
 	
 	//Height of floor and walls
 	UPROPERTY(EditAnywhere, Category = "CA")
@@ -63,33 +131,69 @@ protected:
 	
 	UPROPERTY(EditAnywhere, Category = "CA")
 	float WallHeight = 200.f;
-	
-private:
-	//Grid: true = wall, false = floor
-	TArray<bool> CurrentMap;
-	TArray<bool> NextMap;
 
-	FORCEINLINE int32 Index(int32 X, int32 Y) const
-	{
-		return Y * MapWidth + X;
-	}
+	// ---- Floor Meshing ----
 
-	void InitializeMap();
-	void RunSimulation();
-	void StepSimulation();
-	int32 CountWallNeighbors(int32 X, int32 Y) const;
+	//Merge floor cells into rectangles per chunk and draw each chunk as one procedural mesh
+	//instead of one plane actor per cell. Uses FloorMesh's material
+	UPROPERTY(EditAnywhere, Category = "Floor Meshing")
+	bool bMergeFloorMeshes = true;
 
-	//----Connectivity----
-	void EnsureConnectivity();
-	void FloodFillRegion(int32 StartX, int32 StartY, int32 RegionId, TArray<int32>& OutLabels, TArray<FIntPoint>& OutCells) const;
-	int32 FindClosestPairBetweenRegions(const TArray<FIntPoint>& RegionA, const TArray<FIntPoint>& RegionB, FIntPoint& OutA, FIntPoint& OutB) const;
-	void CarveCorridorBetween(const FIntPoint& A, const FIntPoint& B);
+	//Chunk size in cells
+	UPROPERTY(EditAnywhere, Category = "Floor Meshing", meta = (EditCondition = "bMergeFloorMeshes", ClampMin = "1"))
+	int32 FloorChunkSize = 32;
 
-	void SpawnGeometry();
-	
+	UPROPERTY(VisibleAnywhere, Category = "Components")
+	TObjectPtr<USceneComponent> Root;
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	//One merged floor mesh per chunk
+	UPROPERTY()
+	TArray<TObjectPtr<UProceduralMeshComponent>> FloorChunks;
+
+	//bMergeFloorMeshes path, replaces the per-cell floor planes
+	void BuildMergedFloor();
+
+	// ---- Streaming ----
+
+	//Hand the layout to ChunkStreamer instead of spawning it all at once. Only chunks around
+	//the player get geometry: merged floors and instanced walls, from pooled components
+	UPROPERTY(EditAnywhere, Category = "Streaming")
+	bool bStreamChunks = false;
+
+	UPROPERTY(VisibleAnywhere, Category = "Components")
+	TObjectPtr<UDungeonChunkStreamer> ChunkStreamer;
 
+	void StartStreaming();
+
+	//Unbounded cave generated chunk by chunk on worker threads around the player, through ChunkStreamer.
+	//MapWidth / MapHeight are ignored, chunk size comes from the streamer
+	UPROPERTY(EditAnywhere, Category = "Streaming")
+	bool bInfiniteChunks = false;
+
+	//Settings come from MakeLayoutSettings on the server, from the replicated descriptor on clients
+	void StartInfiniteStreaming(const FCALayoutSettings& Settings);
+
+	//Same walls SpawnGeometry would place, for the cells of Grid in CellRect. See UDungeonChunkStreamer::FGatherWallsFunc
+	void GatherWallTransforms(const FDungeonGrid& Grid, const FIntRect& CellRect, const FIntPoint& CellOffset, TArray<FTransform>& OutTransforms) const;
+
+	// ---- Builder hooks ----
+
+	virtual const TCHAR* GetGeneratorName() const override { return TEXT("CA"); }
+	virtual void GenerateLayout() override;
+	virtual void GenerateLayoutInBackground(TUniqueFunction<void(FDungeonGrid&&)>&& OnBuilt) override;
+	virtual void UpdateGenerationDescriptor() override;
+	virtual void ApplyGenerationDescriptor() override;
+	virtual FDungeonSeedSearchResult SearchSeeds(const FDungeonSeedConstraints& Constraints, int32 NumSeeds, int32 NumBest, int32 FirstSeed) const override;
+	virtual void SpawnGeometry() override;
+	virtual void AddTelemetryDetails(FDungeonGenerationTelemetry& Telemetry) const override;
+
+	//Infinite chunks stream instead of building one layout
+	virtual void GenerateAndSpawn(bool bAsync) override;
+
+	//Streamed layouts can't be baked, merged floors are baked as per-cell actors
+	virtual bool PrepareBake() override;
+	
+private:
+	//Snapshot of the config above with the seed resolved
+	FCALayoutSettings MakeLayoutSettings() const;
 };
@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DungeonActorPool.h"
+#include "DungeonStats.h"
+#include "DungeonMemory.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Components/StaticMeshComponent.h"
+
+void FDungeonActorPool::BeginReuse()
+{
+	//Keep them visible for now, EndReuse hides the ones nobody took
+	Free.Append(Active);
+	Active.Reset();
+
+	NumReused = 0;
+	NumSpawned = 0;
+}
+
+void FDungeonActorPool::EndReuse()
+{
+	for (AStaticMeshActor* Actor : Free)
+	{
+		Deactivate(Actor);
+	}
+}
+
+AStaticMeshActor* FDungeonActorPool::Acquire(UWorld* World, UStaticMesh* Mesh, const FTransform& Transform)
+{
+	DUNGEON_LLM_SCOPE(Actors);
+
+	AStaticMeshActor* Actor = PopFree();
+	if (Actor)
+	{
+		Reuse(Actor, Mesh, Transform);
+	}
+	else
+	{
+		Actor = SpawnDeferred(World, Mesh, Transform);
+		if (!Actor) return nullptr;
+
+		Actor->FinishSpawning(Transform);
+	}
+
+	Active.Add(Actor);
+	return Actor;
+}
+
+void FDungeonActorPool::AcquireBatch(UWorld* World, UStaticMesh* Mesh, const TArray<FTransform>& Transforms, TArray<AStaticMeshActor*>* OutActors)
+{
+	DUNGEON_LLM_SCOPE(Actors);
+
+	if (OutActors)
+	{
+		OutActors->Reset(Transforms.Num());
+	}
+
+	//Index into Transforms for every actor still waiting on FinishSpawning
+	TArray<TPair<AStaticMeshActor*, int32>> Deferred;
+
+	for (int32 i = 0; i < Transforms.Num(); ++i)
+	{
+		AStaticMeshActor* Actor = PopFree();
+		if (Actor)
+		{
+			Reuse(Actor, Mesh, Transforms[i]);
+		}
+		else
+		{
+			Actor = SpawnDeferred(World, Mesh, Transforms[i]);
+			if (Actor) Deferred.Emplace(Actor, i);
+		}
+
+		if (Actor) Active.Add(Actor);
+		if (OutActors) OutActors->Add(Actor);
+	}
+
+	for (const TPair<AStaticMeshActor*, int32>& Pending : Deferred)
+	{
+		Pending.Key->FinishSpawning(Transforms[Pending.Value]);
+	}
+}
+
+AStaticMeshActor* FDungeonActorPool::PopFree()
+{
+	while (Free.Num() > 0)
+	{
+		AStaticMeshActor* Candidate = Free.Pop();
+		if (IsValid(Candidate)) return Candidate;
+	}
+	return nullptr;
+}
+
+void FDungeonActorPool::Reuse(AStaticMeshActor* Actor, UStaticMesh* Mesh, const FTransform& Transform)
+{
+	UStaticMeshComponent* MeshComp = Actor->GetStaticMeshComponent();
+
+	//Static components refuse to move or change mesh while registered. Unregistered they take both,
+	//and registering again rebuilds render and physics state once for the whole change
+	MeshComp->UnregisterComponent();
+
+	Actor->SetActorTransform(Transform);
+	MeshComp->SetStaticMesh(Mesh);
+	Actor->SetActorHiddenInGame(false);
+	Actor->SetActorEnableCollision(true);
+
+	MeshComp->RegisterComponent();
+	++NumReused;
+}
+
+AStaticMeshActor* FDungeonActorPool::SpawnDeferred(UWorld* World, UStaticMesh* Mesh, const FTransform& Transform)
+{
+	if (!World) return nullptr;
+
+	AStaticMeshActor* Actor = World->SpawnActorDeferred<AStaticMeshActor>(AStaticMeshActor::StaticClass(), Transform,
+		nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	if (!Actor) return nullptr;
+
+	UStaticMeshComponent* MeshComp = Actor->GetStaticMeshComponent();
+	if (!MeshComp)
+	{
+		Actor->FinishSpawning(Transform);
+		Actor->Destroy();
+		return nullptr;
+	}
+
+	//Not registered yet, so none of this dirties render state or physics
+	MeshComp->SetMobility(EComponentMobility::Static);
+	MeshComp->SetStaticMesh(Mesh);
+	++NumSpawned;
+	INC_DWORD_STAT(STAT_Dungeon_ActorsSpawned);
+	return Actor;
+}
+
+void FDungeonActorPool::Empty()
+{
+	for (AStaticMeshActor* Actor : Active)
+	{
+		if (IsValid(Actor)) Actor->Destroy();
+	}
+	for (AStaticMeshActor* Actor : Free)
+	{
+		if (IsValid(Actor)) Actor->Destroy();
+	}
+	Active.Reset();
+	Free.Reset();
+}
+
+void FDungeonActorPool::DestroyFree()
+{
+	for (AStaticMeshActor* Actor : Free)
+	{
+		if (IsValid(Actor)) Actor->Destroy();
+	}
+	Free.Reset();
+}
+
+void FDungeonActorPool::MakeStatic()
+{
+	for (AStaticMeshActor* Actor : Active)
+	{
+		if (IsValid(Actor)) Actor->SetMobility(EComponentMobility::Static);
+	}
+}
+
+void FDungeonActorPool::Deactivate(AStaticMeshActor* Actor)
+{
+	if (!IsValid(Actor)) return;
+
+	Actor->SetActorHiddenInGame(true);
+	Actor->SetActorEnableCollision(false);
+}
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DungeonActorPool.generated.h"
+
+class AStaticMeshActor;
+class UStaticMesh;
+
+//Recycles the static mesh actors a generator spawns. Regenerating wraps the spawn pass in
+//BeginReuse / EndReuse, so existing actors are moved into place and only the difference gets spawned or hidden
+USTRUCT()
+struct PROCEDURALDUNGEON4_API FDungeonActorPool
+{
+	GENERATED_BODY()
+
+	//Start a spawn pass, every actor in use becomes available again
+	void BeginReuse();
+
+	//Finish a spawn pass, hide whatever was not picked up again
+	void EndReuse();
+
+	//A visible, colliding, Static actor showing Mesh at Transform. Reused if possible, spawned otherwise.
+	//A reused actor is moved while its mesh component is unregistered, so it never has to change mobility
+	AStaticMeshActor* Acquire(UWorld* World, UStaticMesh* Mesh, const FTransform& Transform);
+
+	//Acquire for many transforms sharing one mesh. New actors are all constructed first and registered
+	//together afterwards. OutActors (optional) lines up with Transforms, nullptr where spawning failed
+	void AcquireBatch(UWorld* World, UStaticMesh* Mesh, const TArray<FTransform>& Transforms, TArray<AStaticMeshActor*>* OutActors = nullptr);
+
+	//Destroy every actor, in use or not
+	void Empty();
+
+	//Destroy only the hidden actors nobody is using, e.g. before the level gets saved
+	void DestroyFree();
+
+	//Give every actor in use Static mobility, so a saved level can build precomputed lighting for them
+	void MakeStatic();
+
+	int32 NumActive() const { return Active.Num(); }
+	int32 NumFree() const { return Free.Num(); }
+
+	//Counters for the current / last pass
+	int32 NumReused = 0;
+	int32 NumSpawned = 0;
+
+private:
+	//Not transient, a baked level keeps its pool and later spawn passes reuse the baked actors
+	UPROPERTY()
+	TArray<TObjectPtr<AStaticMeshActor>> Active;
+
+	UPROPERTY()
+	TArray<TObjectPtr<AStaticMeshActor>> Free;
+
+	//Next valid free actor, nullptr if there is none
+	AStaticMeshActor* PopFree();
+
+	//Move a free actor into place and show it again
+	void Reuse(AStaticMeshActor* Actor, UStaticMesh* Mesh, const FTransform& Transform);
+
+	//Spawn with mesh and mobility set before the components register, caller has to FinishSpawning
+	AStaticMeshActor* SpawnDeferred(UWorld* World, UStaticMesh* Mesh, const FTransform& Transform);
+
+	static void Deactivate(AStaticMeshActor* Actor);
+};
@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Async.h"
+#include "Tasks/Task.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+
+namespace DungeonAsync
+{
+	//Runs Work (the logical phase) on a worker thread, then passes its result to OnDone on the game thread.
+	//OnDone is dropped if Owner was destroyed while the work was in flight.
+	//Work must only touch data it captured by value
+	template<typename WorkType, typename DoneType>
+	void LaunchLayoutTask(const UObject* Owner, WorkType&& Work, DoneType&& OnDone)
+	{
+		UE::Tasks::Launch(UE_SOURCE_LOCATION,
+			[Work = Forward<WorkType>(Work), OnDone = Forward<DoneType>(OnDone), WeakOwner = TWeakObjectPtr<const UObject>(Owner)]() mutable
+			{
+				auto Result = Work();
+
+				AsyncTask(ENamedThreads::GameThread,
+					[Result = MoveTemp(Result), OnDone = MoveTemp(OnDone), WeakOwner]() mutable
+					{
+						if (WeakOwner.IsValid())
+						{
+							OnDone(MoveTemp(Result));
+						}
+					});
+			});
+	}
+}
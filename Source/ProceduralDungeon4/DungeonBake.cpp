@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DungeonBake.h"
+#include "DungeonActorPool.h"
+#include "GameFramework/Actor.h"
+
+void DungeonBake::FinishBake(AActor* Generator, FDungeonActorPool& Pool)
+{
+	if (!Generator) return;
+
+	Generator->Modify();
+
+	TInlineComponentArray<USceneComponent*> Components(Generator);
+	for (USceneComponent* Component : Components)
+	{
+		Component->SetMobility(EComponentMobility::Static);
+	}
+
+	//Floors and walls are pool actors, not components of the generator
+	Pool.MakeStatic();
+	Pool.DestroyFree();
+
+	Generator->MarkPackageDirty();
+
+	UE_LOG(LogTemp, Log, TEXT("DungeonBake: baked %s, %d actors"), *Generator->GetName(), Pool.NumActive());
+}
@@ -0,0 +1,15 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+struct FDungeonActorPool;
+
+namespace DungeonBake
+{
+	//Turn what a generator just spawned into plain level content. The generator's components and every
+	//pool actor in use go Static for precomputed lighting and hidden pool actors are destroyed
+	void FinishBake(AActor* Generator, FDungeonActorPool& Pool);
+}
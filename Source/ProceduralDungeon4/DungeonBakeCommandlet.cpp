@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DungeonBakeCommandlet.h"
+#include "DungeonFloorGeneratorBase.h"
+#include "CA_FloorGenerator.h"
+#include "Walk_FloorGenerator.h"
+#include "Holmquist_FloorGenerator.h"
+#include "BSP_FloorGenerator.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+UDungeonBakeCommandlet::UDungeonBakeCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UDungeonBakeCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	// ---- Arguments ----
+
+	FString GeneratorName = TEXT("CA");
+	FParse::Value(*Params, TEXT("Generator="), GeneratorName);
+
+	int32 SeedValue = 0;
+	const bool bHasSeed = FParse::Value(*Params, TEXT("Seed="), SeedValue);
+
+	FString PackageName;
+	FParse::Value(*Params, TEXT("Map="), PackageName);
+
+	FText Reason;
+	if (!FPackageName::IsValidLongPackageName(PackageName, false, &Reason))
+	{
+		UE_LOG(LogTemp, Error, TEXT("DungeonBake: -Map=%s is not a valid package name: %s"), *PackageName, *Reason.ToString());
+		return 1;
+	}
+
+	UClass* GeneratorClass = ResolveGeneratorClass(GeneratorName);
+	if (!GeneratorClass)
+	{
+		UE_LOG(LogTemp, Error, TEXT("DungeonBake: %s is not a floor generator"), *GeneratorName);
+		return 1;
+	}
+
+	// ---- World ----
+
+	//The world lives in the map package, saving the package writes the map
+	UPackage* Package = CreatePackage(*PackageName);
+	UWorld* World = UWorld::CreateWorld(EWorldType::Editor, false, FName(*FPackageName::GetShortName(PackageName)), Package);
+	World->SetFlags(RF_Public | RF_Standalone);
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Editor);
+	WorldContext.SetCurrentWorld(World);
+
+	// ---- Bake ----
+
+	ADungeonFloorGeneratorBase* Generator = Cast<ADungeonFloorGeneratorBase>(World->SpawnActor(GeneratorClass));
+	const bool bBaked = Generator && Bake(Generator, bHasSeed ? &SeedValue : nullptr);
+
+	bool bSaved = false;
+	const FString Filename = FPackageName::LongPackageNameToFilename(PackageName, FPackageName::GetMapPackageExtension());
+
+	if (bBaked)
+	{
+		FSavePackageArgs SaveArgs;
+		SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+		SaveArgs.Error = GError;
+		bSaved = UPackage::SavePackage(Package, World, *Filename, SaveArgs);
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	if (!bSaved)
+	{
+		UE_LOG(LogTemp, Error, TEXT("DungeonBake: failed to %s %s"), bBaked ? TEXT("save") : TEXT("bake"), *PackageName);
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("DungeonBake: wrote %s"), *Filename);
+	return 0;
+#else
+	UE_LOG(LogTemp, Error, TEXT("DungeonBake: saving maps needs an editor build"));
+	return 1;
+#endif
+}
+
+UClass* UDungeonBakeCommandlet::ResolveGeneratorClass(const FString& Name)
+{
+	if (Name == TEXT("CA")) return ACA_FloorGenerator::StaticClass();
+	if (Name == TEXT("Walk")) return AWalk_FloorGenerator::StaticClass();
+	if (Name == TEXT("Holmquist")) return AHolmquist_FloorGenerator::StaticClass();
+	if (Name == TEXT("BSP")) return ABSP_FloorGenerator::StaticClass();
+
+	//A Blueprint subclass brings its configured meshes and settings along
+	UClass* Class = LoadObject<UClass>(nullptr, *Name);
+	if (!Class) return nullptr;
+
+	return Class->IsChildOf<ADungeonFloorGeneratorBase>() && !Class->HasAnyClassFlags(CLASS_Abstract) ? Class : nullptr;
+}
+
+bool UDungeonBakeCommandlet::Bake(ADungeonFloorGeneratorBase* Gen, const int32* Seed) const
+{
+	if (Seed) Gen->Seed = *Seed;
+
+	//Native classes have no meshes assigned, use the same basic shapes as the benchmark
+	if (!Gen->FloorMesh) Gen->FloorMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Plane.Plane"));
+	if (!Gen->WallMesh) Gen->WallMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+
+	Gen->BakeIntoLevel();
+	if (!Gen->bBakedLayout) return false;
+
+	UE_LOG(LogTemp, Display, TEXT("DungeonBake: %s seed %d, layout hash %s"),
+		*Gen->GetClass()->GetName(), Gen->Seed, *Gen->GetLayoutHashString());
+	return true;
+}
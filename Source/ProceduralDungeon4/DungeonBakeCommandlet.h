@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DungeonBakeCommandlet.generated.h"
+
+class ADungeonFloorGeneratorBase;
+
+//Generates one dungeon and saves it as a map, so shipped builds load static geometry instead of generating.
+//Goes through the generator's own BakeIntoLevel, the same spawn pass the game runs.
+//UnrealEditor-Cmd ProceduralDungeon4.uproject -run=DungeonBake -Map=/Game/Maps/Baked/CaveA -Seed=42
+//	-Generator=CA                           CA, Walk, Holmquist, BSP or a generator Blueprint class path, default CA
+//	-Seed=<n>                               seed to bake, default the generator's own Seed setting
+//	-Map=<package>                          long package name of the map to write, required
+UCLASS()
+class UDungeonBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UDungeonBakeCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	//Short name or class path to a generator class, nullptr if it isn't one
+	static UClass* ResolveGeneratorClass(const FString& Name);
+
+	//Set the seed, fill in basic shapes for missing meshes and bake. False if the bake was refused
+	bool Bake(ADungeonFloorGeneratorBase* Gen, const int32* Seed) const;
+};
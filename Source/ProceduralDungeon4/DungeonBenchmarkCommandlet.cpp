@@ -0,0 +1,411 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DungeonBenchmarkCommandlet.h"
+#include "CA_FloorGenerator.h"
+#include "Walk_FloorGenerator.h"
+#include "Holmquist_FloorGenerator.h"
+#include "BSP_FloorGenerator.h"
+#include "RoomGenerator.h"
+#include "DungeonRoom.h"
+#include "TileOccupancy.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/DateTime.h"
+#include "Hash/xxhash.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "JsonObjectConverter.h"
+
+namespace
+{
+	float MsSince(double StartSeconds)
+	{
+		return (float)((FPlatformTime::Seconds() - StartSeconds) * 1000.0);
+	}
+
+	//Same basic shapes the levels use, so spawn cost includes real mesh assignment
+	UStaticMesh* LoadPlane()
+	{
+		return LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Plane.Plane"));
+	}
+
+	UStaticMesh* LoadCube()
+	{
+		return LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	}
+
+	//"32,64,128" -> {32, 64, 128}, skips anything that isn't a positive number
+	TArray<int32> ParseIntList(const FString& List)
+	{
+		TArray<FString> Parts;
+		List.ParseIntoArray(Parts, TEXT(","));
+
+		TArray<int32> Out;
+		for (const FString& Part : Parts)
+		{
+			const int32 Value = FCString::Atoi(*Part);
+			if (Value > 0) Out.Add(Value);
+		}
+		return Out;
+	}
+}
+
+UDungeonBenchmarkCommandlet::UDungeonBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UDungeonBenchmarkCommandlet::Main(const FString& Params)
+{
+	// ---- Arguments ----
+
+	FString GeneratorList = TEXT("CA,Walk,Holmquist,BSP,Room");
+	FParse::Value(*Params, TEXT("Generators="), GeneratorList);
+
+	FString SizeList = TEXT("32,64,128");
+	FParse::Value(*Params, TEXT("Sizes="), SizeList);
+
+	int32 NumSeeds = 5;
+	FParse::Value(*Params, TEXT("Seeds="), NumSeeds);
+
+	FString OutputDir = FPaths::ProjectSavedDir() / TEXT("Benchmarks");
+	FParse::Value(*Params, TEXT("Output="), OutputDir);
+
+	bSpawn = !FParse::Param(*Params, TEXT("NoSpawn"));
+
+	const bool bVerifyGoldens = FParse::Param(*Params, TEXT("VerifyGoldens"));
+	const bool bUpdateGoldens = FParse::Param(*Params, TEXT("UpdateGoldens"));
+
+	FString GoldensPath = FPaths::ProjectDir() / TEXT("Goldens") / TEXT("DungeonLayoutHashes.csv");
+	FParse::Value(*Params, TEXT("Goldens="), GoldensPath);
+
+	TArray<FString> Generators;
+	GeneratorList.ParseIntoArray(Generators, TEXT(","));
+	const TArray<int32> Sizes = ParseIntList(SizeList);
+
+	if (Generators.Num() == 0 || Sizes.Num() == 0 || NumSeeds <= 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("DungeonBenchmark: nothing to run, check -Generators, -Sizes and -Seeds"));
+		return 1;
+	}
+
+	// ---- World ----
+
+	//Generators only spawn actors and components, a bare game world without BeginPlay is enough
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("DungeonBenchmark"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+
+	// ---- Runs ----
+
+	TArray<FDungeonBenchmarkResult> Results;
+
+	for (const FString& Name : Generators)
+	{
+		for (const int32 Size : Sizes)
+		{
+			for (int32 Seed = 0; Seed < NumSeeds; ++Seed)
+			{
+				FDungeonBenchmarkResult Result;
+				if (Name == TEXT("CA")) Result = RunCA(World, Size, Seed);
+				else if (Name == TEXT("Walk")) Result = RunWalk(World, Size, Seed);
+				else if (Name == TEXT("Holmquist")) Result = RunHolmquist(World, Size, Seed);
+				else if (Name == TEXT("BSP")) Result = RunBSP(World, Size, Seed);
+				else if (Name == TEXT("Room")) Result = RunRoom(World, Size, Seed);
+				else
+				{
+					UE_LOG(LogTemp, Warning, TEXT("DungeonBenchmark: unknown generator %s"), *Name);
+					break;
+				}
+
+				UE_LOG(LogTemp, Display, TEXT("DungeonBenchmark: %s %dx%d seed %d - logical %.2f ms, spawn %.2f ms, %d floor cells, %d actors, hash %s"),
+					*Result.Generator, Result.Width, Result.Height, Result.Seed, Result.LogicalMs, Result.SpawnMs, Result.FloorCells, Result.ActorsSpawned,
+					*Result.LayoutHash);
+				Results.Add(Result);
+			}
+		}
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	// ---- Output ----
+
+	const FString Stamp = FDateTime::Now().ToString(TEXT("%Y%m%d-%H%M%S"));
+	const FString BaseName = OutputDir / FString::Printf(TEXT("DungeonBenchmark-%s"), *Stamp);
+
+	const bool bWritten = WriteCSV(BaseName + TEXT(".csv"), Results) && WriteJSON(BaseName + TEXT(".json"), Results);
+	if (!bWritten)
+	{
+		UE_LOG(LogTemp, Error, TEXT("DungeonBenchmark: failed to write results to %s"), *OutputDir);
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("DungeonBenchmark: %d runs written to %s.csv/.json"), Results.Num(), *BaseName);
+
+	// ---- Goldens ----
+
+	if (bUpdateGoldens && !UpdateGoldens(GoldensPath, Results))
+	{
+		UE_LOG(LogTemp, Error, TEXT("DungeonBenchmark: failed to write goldens to %s"), *GoldensPath);
+		return 1;
+	}
+
+	if (bVerifyGoldens && VerifyGoldens(GoldensPath, Results) > 0)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+template <typename GeneratorType, typename BuilderType>
+FDungeonBenchmarkResult UDungeonBenchmarkCommandlet::RunBuilder(UWorld* World, const TCHAR* Name, BuilderType Builder, void (BuilderType::*Build)(), int32 Size) const
+{
+	FDungeonBenchmarkResult Result;
+	Result.Generator = Name;
+	Result.Width = Size;
+	Result.Height = Size;
+	Result.Seed = Builder.Settings.Seed;
+
+	double Start = FPlatformTime::Seconds();
+	(Builder.*Build)();
+	Result.LogicalMs = MsSince(Start);
+	Result.FloorCells = Builder.Grid.CountFloorCells();
+
+	if (bSpawn)
+	{
+		GeneratorType* Gen = World->SpawnActor<GeneratorType>();
+		Gen->Seed = Builder.Settings.Seed;
+		Gen->FloorMesh = LoadPlane();
+		Gen->WallMesh = LoadCube();
+
+		Start = FPlatformTime::Seconds();
+		Gen->SpawnLayout(Builder.Grid);
+		Result.SpawnMs = MsSince(Start);
+		Result.ActorsSpawned = Gen->ActorPool.NumSpawned;
+
+		Gen->ActorPool.Empty();
+		Gen->Destroy();
+	}
+
+	Result.LayoutHash = DungeonGrid::LayoutHashToString(Builder.Grid.ComputeLayoutHash());
+	return Result;
+}
+
+FDungeonBenchmarkResult UDungeonBenchmarkCommandlet::RunCA(UWorld* World, int32 Size, int32 Seed) const
+{
+	FCALayoutSettings Settings;
+	Settings.MapWidth = Size;
+	Settings.MapHeight = Size;
+	Settings.Seed = Seed;
+
+	return RunBuilder<ACA_FloorGenerator>(World, TEXT("CA"), FCALayoutBuilder(Settings), &FCALayoutBuilder::Build, Size);
+}
+
+FDungeonBenchmarkResult UDungeonBenchmarkCommandlet::RunWalk(UWorld* World, int32 Size, int32 Seed) const
+{
+	FWalkLayoutSettings Settings;
+	Settings.MapWidth = Size;
+	Settings.MapHeight = Size;
+	//Aim for roughly half the map as floor, like the default 1000 steps on 60x40
+	Settings.NumSteps = Size * Size / 2;
+	Settings.Seed = Seed;
+
+	return RunBuilder<AWalk_FloorGenerator>(World, TEXT("Walk"), FWalkLayoutBuilder(Settings), &FWalkLayoutBuilder::GenerateMap, Size);
+}
+
+FDungeonBenchmarkResult UDungeonBenchmarkCommandlet::RunHolmquist(UWorld* World, int32 Size, int32 Seed) const
+{
+	FHolmquistLayoutSettings Settings;
+	Settings.GridWidth = Size;
+	Settings.GridHeight = Size;
+	Settings.NumTiles = Size * Size / 2;
+	Settings.Seed = Seed;
+
+	return RunBuilder<AHolmquist_FloorGenerator>(World, TEXT("Holmquist"), FHolmquistLayoutBuilder(Settings), &FHolmquistLayoutBuilder::GenerateRoomLayout, Size);
+}
+
+FDungeonBenchmarkResult UDungeonBenchmarkCommandlet::RunBSP(UWorld* World, int32 Size, int32 Seed) const
+{
+	FBSPLayoutSettings Settings;
+	Settings.MapSize = FIntPoint(Size, Size);
+	Settings.Seed = Seed;
+
+	return RunBuilder<ABSP_FloorGenerator>(World, TEXT("BSP"), FBSPLayoutBuilder(Settings), &FBSPLayoutBuilder::GenerateBSP, Size);
+}
+
+FDungeonBenchmarkResult UDungeonBenchmarkCommandlet::RunRoom(UWorld* World, int32 Size, int32 Seed) const
+{
+	FDungeonBenchmarkResult Result;
+	Result.Generator = TEXT("Room");
+	Result.Width = Size;
+	Result.Height = Size;
+	Result.Seed = Seed;
+
+	//Room growth has no grid, grow half of Size x Size tiles to match the other generators
+	const int32 TilesToCreate = Size * Size / 2;
+
+	double Start = FPlatformTime::Seconds();
+	{
+		FTileOccupancyGrid Occupied;
+		FRandomStream Rng(Seed);
+		TArray<FIntPoint> Coords;
+		ARoomGenerator::GrowRoomLayout(TilesToCreate, FIntPoint::ZeroValue, Rng, Occupied, Coords);
+		Result.LogicalMs = MsSince(Start);
+		Result.FloorCells = Coords.Num();
+
+		//No grid here, the tile coordinates in growth order are the whole logical output
+		Result.LayoutHash = DungeonGrid::LayoutHashToString(FXxHash64::HashBuffer(Coords.GetData(), Coords.Num() * sizeof(FIntPoint)).Hash);
+	}
+
+	if (bSpawn)
+	{
+		UTileOccupancySubsystem* Occupancy = World->GetSubsystem<UTileOccupancySubsystem>();
+		if (Occupancy) Occupancy->GetTiles().Reset();
+
+		ARoomGenerator* Gen = World->SpawnActor<ARoomGenerator>();
+		Gen->Seed = Seed;
+		Gen->DungeonRoomClass = ADungeonRoom::StaticClass();
+		Gen->bUseInstancedTiles = true;
+
+		//GenerateRoom has no separate spawn step, so this includes growing the room again
+		Start = FPlatformTime::Seconds();
+		ADungeonRoom* Room = Gen->GenerateRoom(TilesToCreate);
+		Result.SpawnMs = MsSince(Start);
+		Result.ActorsSpawned = Room ? 1 : 0;
+
+		if (Room) Room->Destroy();
+		Gen->Destroy();
+	}
+
+	return Result;
+}
+
+bool UDungeonBenchmarkCommandlet::WriteCSV(const FString& Path, const TArray<FDungeonBenchmarkResult>& Results)
+{
+	FString Csv = TEXT("Generator,Width,Height,Seed,LogicalMs,SpawnMs,FloorCells,ActorsSpawned,LayoutHash\n");
+	for (const FDungeonBenchmarkResult& R : Results)
+	{
+		Csv += FString::Printf(TEXT("%s,%d,%d,%d,%.3f,%.3f,%d,%d,%s\n"),
+			*R.Generator, R.Width, R.Height, R.Seed, R.LogicalMs, R.SpawnMs, R.FloorCells, R.ActorsSpawned, *R.LayoutHash);
+	}
+	return FFileHelper::SaveStringToFile(Csv, *Path);
+}
+
+bool UDungeonBenchmarkCommandlet::WriteJSON(const FString& Path, const TArray<FDungeonBenchmarkResult>& Results)
+{
+	TArray<TSharedPtr<FJsonValue>> Runs;
+	for (const FDungeonBenchmarkResult& R : Results)
+	{
+		TSharedPtr<FJsonObject> Run = FJsonObjectConverter::UStructToJsonObject(R);
+		if (Run.IsValid()) Runs.Add(MakeShared<FJsonValueObject>(Run));
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetStringField(TEXT("Timestamp"), FDateTime::UtcNow().ToIso8601());
+	Root->SetArrayField(TEXT("Runs"), Runs);
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	if (!FJsonSerializer::Serialize(Root, Writer)) return false;
+
+	return FFileHelper::SaveStringToFile(Json, *Path);
+}
+
+FString UDungeonBenchmarkCommandlet::GoldenKey(const FDungeonBenchmarkResult& Result)
+{
+	return FString::Printf(TEXT("%s,%d,%d,%d"), *Result.Generator, Result.Width, Result.Height, Result.Seed);
+}
+
+bool UDungeonBenchmarkCommandlet::LoadGoldens(const FString& Path, TMap<FString, FString>& OutHashes)
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *Path)) return false;
+
+	//Generator,Width,Height,Seed,LayoutHash - the key is everything before the last comma
+	for (int32 i = 1; i < Lines.Num(); ++i)
+	{
+		int32 Split = INDEX_NONE;
+		if (!Lines[i].FindLastChar(TEXT(','), Split)) continue;
+
+		OutHashes.Add(Lines[i].Left(Split), Lines[i].Mid(Split + 1).TrimStartAndEnd());
+	}
+	return true;
+}
+
+int32 UDungeonBenchmarkCommandlet::VerifyGoldens(const FString& Path, const TArray<FDungeonBenchmarkResult>& Results) const
+{
+	TMap<FString, FString> Goldens;
+	if (!LoadGoldens(Path, Goldens))
+	{
+		UE_LOG(LogTemp, Error, TEXT("DungeonBenchmark: no goldens at %s, record them with -UpdateGoldens"), *Path);
+		return Results.Num();
+	}
+
+	int32 NumMismatched = 0;
+	int32 NumMissing = 0;
+
+	for (const FDungeonBenchmarkResult& Result : Results)
+	{
+		const FString Key = GoldenKey(Result);
+		const FString* Golden = Goldens.Find(Key);
+		if (!Golden)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("DungeonBenchmark: no golden for %s"), *Key);
+			++NumMissing;
+			continue;
+		}
+
+		if (*Golden != Result.LayoutHash)
+		{
+			UE_LOG(LogTemp, Error, TEXT("DungeonBenchmark: %s changed, layout hash %s, golden %s"), *Key, *Result.LayoutHash, **Golden);
+			++NumMismatched;
+		}
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("DungeonBenchmark: goldens %s - %d matched, %d changed, %d missing"),
+		NumMismatched > 0 ? TEXT("FAILED") : TEXT("passed"), Results.Num() - NumMismatched - NumMissing, NumMismatched, NumMissing);
+
+	//Missing entries are new layouts, not regressions. They count once they are recorded
+	if (NumMissing > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("DungeonBenchmark: record the %d missing goldens with -UpdateGoldens"), NumMissing);
+	}
+	return NumMismatched;
+}
+
+bool UDungeonBenchmarkCommandlet::UpdateGoldens(const FString& Path, const TArray<FDungeonBenchmarkResult>& Results) const
+{
+	//Keep entries for generators and sizes this run didn't cover
+	TMap<FString, FString> Goldens;
+	LoadGoldens(Path, Goldens);
+
+	for (const FDungeonBenchmarkResult& Result : Results)
+	{
+		Goldens.Add(GoldenKey(Result), Result.LayoutHash);
+	}
+
+	//Sorted, so re-recording unchanged layouts leaves the file byte for byte the same
+	Goldens.KeySort(TLess<FString>());
+
+	FString Csv = TEXT("Generator,Width,Height,Seed,LayoutHash\n");
+	for (const TPair<FString, FString>& Golden : Goldens)
+	{
+		Csv += Golden.Key + TEXT(",") + Golden.Value + TEXT("\n");
+	}
+
+	if (!FFileHelper::SaveStringToFile(Csv, *Path)) return false;
+
+	UE_LOG(LogTemp, Display, TEXT("DungeonBenchmark: %d goldens written to %s"), Goldens.Num(), *Path);
+	return true;
+}
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DungeonBenchmarkCommandlet.generated.h"
+
+//One generator run at one size and seed
+USTRUCT()
+struct FDungeonBenchmarkResult
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FString Generator;
+
+	UPROPERTY()
+	int32 Width = 0;
+
+	UPROPERTY()
+	int32 Height = 0;
+
+	UPROPERTY()
+	int32 Seed = 0;
+
+	//Builder only, no world access
+	UPROPERTY()
+	float LogicalMs = 0.f;
+
+	//Meshes, instances and actors for the finished layout on the game thread
+	UPROPERTY()
+	float SpawnMs = 0.f;
+
+	UPROPERTY()
+	int32 FloorCells = 0;
+
+	UPROPERTY()
+	int32 ActorsSpawned = 0;
+
+	//Generator's layout hash as 16 hex digits
+	UPROPERTY()
+	FString LayoutHash;
+};
+
+//Headless generation benchmark, writes CSV and JSON to Saved/Benchmarks.
+//UnrealEditor-Cmd ProceduralDungeon4.uproject -run=DungeonBenchmark -nullrhi
+//	-Generators=CA,Walk,Holmquist,BSP,Room  which generators to run, default all
+//	-Sizes=32,64,128                        grid sizes, every generator runs Size x Size
+//	-Seeds=5                                seeds 0..Seeds-1 per size
+//	-NoSpawn                                logical generation only
+//	-Output=<dir>                           instead of Saved/Benchmarks
+//	-VerifyGoldens                          compare every layout hash with the goldens, fail on any difference
+//	-UpdateGoldens                          record the layout hashes of this run as the new goldens
+//	-Goldens=<file>                         instead of Goldens/DungeonLayoutHashes.csv in the project directory
+UCLASS()
+class UDungeonBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UDungeonBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	bool bSpawn = true;
+
+	FDungeonBenchmarkResult RunCA(UWorld* World, int32 Size, int32 Seed) const;
+	FDungeonBenchmarkResult RunWalk(UWorld* World, int32 Size, int32 Seed) const;
+	FDungeonBenchmarkResult RunHolmquist(UWorld* World, int32 Size, int32 Seed) const;
+	FDungeonBenchmarkResult RunBSP(UWorld* World, int32 Size, int32 Seed) const;
+	FDungeonBenchmarkResult RunRoom(UWorld* World, int32 Size, int32 Seed) const;
+
+	//Time Build on Builder, then spawn its grid through a GeneratorType with the basic shapes unless -NoSpawn
+	template <typename GeneratorType, typename BuilderType>
+	FDungeonBenchmarkResult RunBuilder(UWorld* World, const TCHAR* Name, BuilderType Builder, void (BuilderType::*Build)(), int32 Size) const;
+
+	//"Generator,Width,Height,Seed". Only the logical phase is hashed, so spawning or not gives the same key
+	static FString GoldenKey(const FDungeonBenchmarkResult& Result);
+
+	//Number of layouts whose hash differs from the goldens, missing entries only warn
+	int32 VerifyGoldens(const FString& Path, const TArray<FDungeonBenchmarkResult>& Results) const;
+	bool UpdateGoldens(const FString& Path, const TArray<FDungeonBenchmarkResult>& Results) const;
+
+	static bool LoadGoldens(const FString& Path, TMap<FString, FString>& OutHashes);
+
+	static bool WriteCSV(const FString& Path, const TArray<FDungeonBenchmarkResult>& Results);
+	static bool WriteJSON(const FString& Path, const TArray<FDungeonBenchmarkResult>& Results);
+};
@@ -0,0 +1,332 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DungeonChunkStreamer.h"
+#include "DungeonMeshing.h"
+#include "DungeonAsync.h"
+#include "DungeonStats.h"
+#include "DungeonMemory.h"
+#include "ProceduralMeshComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "GameFramework/Pawn.h"
+#include "Kismet/GameplayStatics.h"
+
+UDungeonChunkStreamer::UDungeonChunkStreamer()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+void UDungeonChunkStreamer::BeginPlay()
+{
+	Super::BeginPlay();
+
+	PrimaryComponentTick.TickInterval = UpdateInterval;
+}
+
+void UDungeonChunkStreamer::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ClearLayout();
+	Super::EndPlay(EndPlayReason);
+}
+
+void UDungeonChunkStreamer::SetLayout(const FDungeonGrid& InGrid, USceneComponent* AttachTo, float InTileSize, const FVector& InCellOrigin,
+	UMaterialInterface* InFloorMaterial, UStaticMesh* InWallMesh, FGatherWallsFunc InGatherWalls)
+{
+	ClearLayout();
+
+	if (!InGrid.IsValid() || !AttachTo)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("DungeonChunkStreamer: SetLayout called with an empty layout or no attach component."));
+		return;
+	}
+
+	Grid = InGrid;
+	SetupCommon(AttachTo, InTileSize, InCellOrigin, InFloorMaterial, InWallMesh, MoveTemp(InGatherWalls));
+}
+
+void UDungeonChunkStreamer::SetChunkProvider(FChunkProviderFunc InProvider, USceneComponent* AttachTo, float InTileSize, const FVector& InCellOrigin,
+	UMaterialInterface* InFloorMaterial, UStaticMesh* InWallMesh, FGatherWallsFunc InGatherWalls)
+{
+	ClearLayout();
+
+	if (!InProvider || !AttachTo)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("DungeonChunkStreamer: SetChunkProvider called without a provider or attach component."));
+		return;
+	}
+
+	Provider = MoveTemp(InProvider);
+	SetupCommon(AttachTo, InTileSize, InCellOrigin, InFloorMaterial, InWallMesh, MoveTemp(InGatherWalls));
+}
+
+void UDungeonChunkStreamer::SetupCommon(USceneComponent* AttachTo, float InTileSize, const FVector& InCellOrigin,
+	UMaterialInterface* InFloorMaterial, UStaticMesh* InWallMesh, FGatherWallsFunc InGatherWalls)
+{
+	AttachParent = AttachTo;
+	TileSize = InTileSize;
+	CellOrigin = InCellOrigin;
+	FloorMaterial = InFloorMaterial;
+	WallMesh = InWallMesh;
+	GatherWalls = MoveTemp(InGatherWalls);
+
+	//Pooled wall components may still hold another mesh
+	for (UInstancedStaticMeshComponent* WallComp : Walls)
+	{
+		if (WallComp) WallComp->SetStaticMesh(WallMesh);
+	}
+
+	SetComponentTickEnabled(true);
+
+	//First batch right away instead of waiting for the first interval
+	FVector ViewerLocal;
+	if (GetViewerLocation(ViewerLocal))
+	{
+		UpdateStreaming(ViewerLocal);
+	}
+}
+
+void UDungeonChunkStreamer::ClearLayout()
+{
+	for (const TPair<FIntPoint, int32>& Pair : LoadedChunks)
+	{
+		if (Pair.Value != INDEX_NONE)
+		{
+			UnloadChunk(Pair.Value);
+		}
+	}
+	LoadedChunks.Reset();
+	PendingChunks.Reset();
+	++LayoutVersion;
+
+	Grid = FDungeonGrid();
+	Provider = nullptr;
+	GatherWalls = nullptr;
+	SetComponentTickEnabled(false);
+}
+
+void UDungeonChunkStreamer::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	FVector ViewerLocal;
+	if (GetViewerLocation(ViewerLocal))
+	{
+		UpdateStreaming(ViewerLocal);
+	}
+}
+
+bool UDungeonChunkStreamer::GetViewerLocation(FVector& OutLocal) const
+{
+	const APawn* Pawn = UGameplayStatics::GetPlayerPawn(this, 0);
+	if (!Pawn || !AttachParent) return false;
+
+	OutLocal = AttachParent->GetComponentTransform().InverseTransformPosition(Pawn->GetActorLocation());
+	return true;
+}
+
+FIntRect UDungeonChunkStreamer::GetChunkCellRect(const FIntPoint& Chunk) const
+{
+	const FIntPoint Min = Chunk * ChunkSize;
+	if (Provider)
+	{
+		return FIntRect(Min, Min + FIntPoint(ChunkSize, ChunkSize));
+	}
+	return FIntRect(Min.X, Min.Y, FMath::Min(Min.X + ChunkSize, Grid.Width), FMath::Min(Min.Y + ChunkSize, Grid.Height));
+}
+
+float UDungeonChunkStreamer::DistanceToChunk(const FVector& Local, const FIntPoint& Chunk) const
+{
+	const FIntRect Cells = GetChunkCellRect(Chunk);
+	const FVector2D Min(CellOrigin.X + Cells.Min.X * TileSize, CellOrigin.Y + Cells.Min.Y * TileSize);
+	const FVector2D Max(CellOrigin.X + Cells.Max.X * TileSize, CellOrigin.Y + Cells.Max.Y * TileSize);
+
+	const float DX = FMath::Max3(Min.X - Local.X, 0.f, Local.X - Max.X);
+	const float DY = FMath::Max3(Min.Y - Local.Y, 0.f, Local.Y - Max.Y);
+	return FMath::Sqrt(DX * DX + DY * DY);
+}
+
+void UDungeonChunkStreamer::UpdateStreaming(const FVector& ViewerLocal)
+{
+	if (!IsStreaming()) return;
+
+	//---- Unload ----
+
+	for (auto It = LoadedChunks.CreateIterator(); It; ++It)
+	{
+		if (DistanceToChunk(ViewerLocal, It.Key()) > UnloadRadius)
+		{
+			if (It.Value() != INDEX_NONE)
+			{
+				UnloadChunk(It.Value());
+			}
+			It.RemoveCurrent();
+		}
+	}
+
+	//---- Load ----
+
+	const float ChunkWorldSize = ChunkSize * TileSize;
+
+	//Only look at chunks whose bounds could be within LoadRadius
+	int32 MinX = FMath::FloorToInt((ViewerLocal.X - LoadRadius - CellOrigin.X) / ChunkWorldSize);
+	int32 MinY = FMath::FloorToInt((ViewerLocal.Y - LoadRadius - CellOrigin.Y) / ChunkWorldSize);
+	int32 MaxX = FMath::FloorToInt((ViewerLocal.X + LoadRadius - CellOrigin.X) / ChunkWorldSize);
+	int32 MaxY = FMath::FloorToInt((ViewerLocal.Y + LoadRadius - CellOrigin.Y) / ChunkWorldSize);
+
+	//A finished grid has bounds, provider chunks don't
+	if (!Provider)
+	{
+		const FIntPoint NumChunks((Grid.Width + ChunkSize - 1) / ChunkSize, (Grid.Height + ChunkSize - 1) / ChunkSize);
+		MinX = FMath::Max(0, MinX);
+		MinY = FMath::Max(0, MinY);
+		MaxX = FMath::Min(NumChunks.X - 1, MaxX);
+		MaxY = FMath::Min(NumChunks.Y - 1, MaxY);
+	}
+
+	TArray<TPair<float, FIntPoint>> Candidates;
+	for (int32 y = MinY; y <= MaxY; ++y)
+	{
+		for (int32 x = MinX; x <= MaxX; ++x)
+		{
+			const FIntPoint Chunk(x, y);
+			if (LoadedChunks.Contains(Chunk) || PendingChunks.Contains(Chunk)) continue;
+
+			const float Distance = DistanceToChunk(ViewerLocal, Chunk);
+			if (Distance <= LoadRadius)
+			{
+				Candidates.Emplace(Distance, Chunk);
+			}
+		}
+	}
+
+	Candidates.Sort([](const TPair<float, FIntPoint>& A, const TPair<float, FIntPoint>& B)
+	{
+		return A.Key < B.Key;
+	});
+
+	//Tasks in flight count against the budget too, so a fast-moving player can't queue up unbounded work
+	const int32 NumToLoad = FMath::Min(Candidates.Num(), MaxLoadsPerUpdate - PendingChunks.Num());
+	for (int32 i = 0; i < NumToLoad; ++i)
+	{
+		const FIntPoint& Chunk = Candidates[i].Value;
+		if (Provider)
+		{
+			RequestChunk(Chunk);
+		}
+		else
+		{
+			LoadChunk(Chunk, Grid, GetChunkCellRect(Chunk), FIntPoint::ZeroValue);
+		}
+	}
+}
+
+void UDungeonChunkStreamer::RequestChunk(const FIntPoint& Chunk)
+{
+	PendingChunks.Add(Chunk);
+
+	DungeonAsync::LaunchLayoutTask(this,
+		[Provider = Provider, Chunk]()
+		{
+			return Provider(Chunk);
+		},
+		[this, Chunk, Version = LayoutVersion](FDungeonGrid&& ChunkGrid)
+		{
+			//Cleared or replaced while this chunk was generating
+			if (Version != LayoutVersion) return;
+
+			OnChunkGenerated(Chunk, ChunkGrid);
+		});
+}
+
+void UDungeonChunkStreamer::OnChunkGenerated(const FIntPoint& Chunk, const FDungeonGrid& ChunkGrid)
+{
+	PendingChunks.Remove(Chunk);
+
+	//The player may have moved on while it was generating
+	FVector ViewerLocal;
+	if (GetViewerLocation(ViewerLocal) && DistanceToChunk(ViewerLocal, Chunk) > UnloadRadius)
+	{
+		return;
+	}
+
+	LoadChunk(Chunk, ChunkGrid, FIntRect(0, 0, ChunkGrid.Width, ChunkGrid.Height), Chunk * ChunkSize);
+}
+
+void UDungeonChunkStreamer::LoadChunk(const FIntPoint& Chunk, const FDungeonGrid& SourceGrid, const FIntRect& CellRect, const FIntPoint& CellOffset)
+{
+	DUNGEON_LLM_SCOPE(Actors);
+	DUNGEON_SCOPE(LoadChunk);
+
+	const FVector ChunkOrigin = CellOrigin + FVector(CellOffset.X * TileSize, CellOffset.Y * TileSize, 0.f);
+
+	FDungeonMeshData Mesh;
+	DungeonMeshing::BuildChunkFloorMesh(SourceGrid, CellRect, TileSize, ChunkOrigin, Mesh);
+
+	TArray<FTransform> WallTransforms;
+	if (GatherWalls && WallMesh)
+	{
+		GatherWalls(SourceGrid, CellRect, CellOffset, WallTransforms);
+	}
+
+	if (Mesh.IsEmpty() && WallTransforms.Num() == 0)
+	{
+		LoadedChunks.Add(Chunk, INDEX_NONE);
+		return;
+	}
+
+	const int32 Visual = AcquireVisual();
+	UProceduralMeshComponent* Floor = Floors[Visual];
+	UInstancedStaticMeshComponent* WallComp = Walls[Visual];
+
+	if (!Mesh.IsEmpty())
+	{
+		Floor->CreateMeshSection(0, Mesh.Vertices, Mesh.Triangles, Mesh.Normals, Mesh.UVs,
+			TArray<FColor>(), TArray<FProcMeshTangent>(), true);
+		Floor->SetMaterial(0, FloorMaterial);
+	}
+
+	if (WallTransforms.Num() > 0)
+	{
+		WallComp->AddInstances(WallTransforms, false);
+	}
+
+	Floor->SetVisibility(true);
+	WallComp->SetVisibility(true);
+
+	LoadedChunks.Add(Chunk, Visual);
+}
+
+void UDungeonChunkStreamer::UnloadChunk(int32 Visual)
+{
+	//Keep the components, just empty them
+	Floors[Visual]->ClearAllMeshSections();
+	Floors[Visual]->SetVisibility(false);
+
+	Walls[Visual]->ClearInstances();
+	Walls[Visual]->SetVisibility(false);
+
+	FreeVisuals.Add(Visual);
+}
+
+int32 UDungeonChunkStreamer::AcquireVisual()
+{
+	if (FreeVisuals.Num() > 0)
+	{
+		return FreeVisuals.Pop();
+	}
+
+	AActor* Owner = GetOwner();
+
+	UProceduralMeshComponent* Floor = NewObject<UProceduralMeshComponent>(Owner);
+	Floor->SetupAttachment(AttachParent);
+	Floor->RegisterComponent();
+
+	UInstancedStaticMeshComponent* WallComp = NewObject<UInstancedStaticMeshComponent>(Owner);
+	WallComp->SetupAttachment(AttachParent);
+	WallComp->SetStaticMesh(WallMesh);
+	WallComp->RegisterComponent();
+
+	Floors.Add(Floor);
+	return Walls.Add(WallComp);
+}
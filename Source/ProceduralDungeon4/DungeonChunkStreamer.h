@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "DungeonGrid.h"
+#include "DungeonChunkStreamer.generated.h"
+
+class UMaterialInterface;
+class UStaticMesh;
+class UProceduralMeshComponent;
+class UInstancedStaticMeshComponent;
+
+//Streams dungeon geometry in ChunkSize x ChunkSize chunks around the player pawn.
+//Chunks load inside LoadRadius and unload outside UnloadRadius, the gap between the two keeps
+//chunks at the border from flickering in and out. Unloaded chunks hand their components back to a pool.
+//The cells come either from one finished grid (SetLayout) or are generated per chunk on worker
+//threads as the player moves (SetChunkProvider), which has no map bounds at all
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class PROCEDURALDUNGEON4_API UDungeonChunkStreamer : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UDungeonChunkStreamer();
+
+	//Fills OutTransforms with wall instances for the cells of Grid in CellRect, relative to the attach component.
+	//Cell (x, y) of Grid is cell (x, y) + CellOffset of the whole dungeon
+	using FGatherWallsFunc = TFunction<void(const FDungeonGrid& Grid, const FIntRect& CellRect, const FIntPoint& CellOffset, TArray<FTransform>& OutTransforms)>;
+
+	//Generates the ChunkSize x ChunkSize cells of one chunk. Called on worker threads, so it must only use captured copies
+	using FChunkProviderFunc = TFunction<FDungeonGrid(const FIntPoint& Chunk)>;
+
+	//Start streaming InGrid. CellOrigin is the local position of cell (0,0)'s min corner,
+	//geometry is attached to AttachTo. Drops whatever was streamed before
+	void SetLayout(const FDungeonGrid& InGrid, USceneComponent* AttachTo, float InTileSize, const FVector& InCellOrigin,
+		UMaterialInterface* InFloorMaterial, UStaticMesh* InWallMesh, FGatherWallsFunc InGatherWalls);
+
+	//Start streaming chunks from Provider, generated on demand with no map bounds.
+	//Only chunks inside UnloadRadius are kept, so memory stays constant however far the player goes
+	void SetChunkProvider(FChunkProviderFunc InProvider, USceneComponent* AttachTo, float InTileSize, const FVector& InCellOrigin,
+		UMaterialInterface* InFloorMaterial, UStaticMesh* InWallMesh, FGatherWallsFunc InGatherWalls);
+
+	//Unload everything and stop streaming. Pooled components are kept
+	UFUNCTION(BlueprintCallable, Category = "Dungeon|Streaming")
+	void ClearLayout();
+
+	UFUNCTION(BlueprintCallable, Category = "Dungeon|Streaming")
+	int32 GetNumLoadedChunks() const { return LoadedChunks.Num(); }
+
+	//Chunk edge length in cells
+	UPROPERTY(EditAnywhere, Category = "Dungeon|Streaming", meta = (ClampMin = "1"))
+	int32 ChunkSize = 32;
+
+	//Chunks closer than this to the player (world units, 2D) get loaded
+	UPROPERTY(EditAnywhere, Category = "Dungeon|Streaming")
+	float LoadRadius = 5000.f;
+
+	//Loaded chunks further than this get released. Keep it above LoadRadius
+	UPROPERTY(EditAnywhere, Category = "Dungeon|Streaming")
+	float UnloadRadius = 6500.f;
+
+	//Seconds between streaming updates
+	UPROPERTY(EditAnywhere, Category = "Dungeon|Streaming")
+	float UpdateInterval = 0.25f;
+
+	//Caps the game thread cost of one update, nearest chunks go first
+	UPROPERTY(EditAnywhere, Category = "Dungeon|Streaming", meta = (ClampMin = "1"))
+	int32 MaxLoadsPerUpdate = 4;
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	//Finite mode: the whole dungeon
+	FDungeonGrid Grid;
+
+	//Provider mode: generates chunks, Grid stays empty
+	FChunkProviderFunc Provider;
+
+	//Chunks with a generation task in flight
+	TSet<FIntPoint> PendingChunks;
+
+	//Bumped on every Set / Clear so results of tasks from an older layout get dropped
+	int32 LayoutVersion = 0;
+
+	float TileSize = 100.f;
+	FVector CellOrigin = FVector::ZeroVector;
+	FGatherWallsFunc GatherWalls;
+
+	UPROPERTY(Transient)
+	TObjectPtr<USceneComponent> AttachParent;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UMaterialInterface> FloorMaterial;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UStaticMesh> WallMesh;
+
+	//Pooled components, Floors[i] and Walls[i] make up one chunk's visuals
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UProceduralMeshComponent>> Floors;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UInstancedStaticMeshComponent>> Walls;
+
+	TArray<int32> FreeVisuals;
+
+	//Chunk coord -> visual index, INDEX_NONE for chunks with nothing in them
+	TMap<FIntPoint, int32> LoadedChunks;
+
+	void UpdateStreaming(const FVector& ViewerLocal);
+
+	void SetupCommon(USceneComponent* AttachTo, float InTileSize, const FVector& InCellOrigin,
+		UMaterialInterface* InFloorMaterial, UStaticMesh* InWallMesh, FGatherWallsFunc InGatherWalls);
+
+	void RequestChunk(const FIntPoint& Chunk);
+	void OnChunkGenerated(const FIntPoint& Chunk, const FDungeonGrid& ChunkGrid);
+
+	//Build visuals for CellRect of SourceGrid, whose cell (0,0) is dungeon cell CellOffset
+	void LoadChunk(const FIntPoint& Chunk, const FDungeonGrid& SourceGrid, const FIntRect& CellRect, const FIntPoint& CellOffset);
+	void UnloadChunk(int32 Visual);
+
+	int32 AcquireVisual();
+
+	FIntRect GetChunkCellRect(const FIntPoint& Chunk) const;
+
+	//2D distance from a local position to the chunk's bounds, 0 inside
+	float DistanceToChunk(const FVector& Local, const FIntPoint& Chunk) const;
+
+	bool GetViewerLocation(FVector& OutLocal) const;
+
+	bool IsStreaming() const { return Grid.IsValid() || Provider; }
+};
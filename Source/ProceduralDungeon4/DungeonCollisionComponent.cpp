@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DungeonCollisionComponent.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "PhysicsEngine/BoxElem.h"
+#include "Engine/CollisionProfile.h"
+
+UDungeonCollisionComponent::UDungeonCollisionComponent()
+	: LocalBounds(ForceInit)
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	SetGenerateOverlapEvents(false);
+	bHiddenInGame = true;
+	SetCastShadow(false);
+}
+
+void UDungeonCollisionComponent::SetBoxes(const TArray<FBox>& InBoxes)
+{
+	Boxes = InBoxes;
+	BuildBodySetup();
+	RebuildPhysicsState();
+}
+
+void UDungeonCollisionComponent::OnRegister()
+{
+	//Loaded from a baked level: only the boxes were saved, the body has to exist before bounds and physics state
+	if (!BodySetup && Boxes.Num() > 0)
+	{
+		BuildBodySetup();
+		BodySetup->CreatePhysicsMeshes();
+	}
+
+	Super::OnRegister();
+}
+
+void UDungeonCollisionComponent::BuildBodySetup()
+{
+	if (!BodySetup)
+	{
+		BodySetup = NewObject<UBodySetup>(this, NAME_None, RF_Transient);
+		BodySetup->BodySetupGuid = FGuid::NewGuid();
+		BodySetup->CollisionTraceFlag = CTF_UseSimpleAsComplex;
+		BodySetup->bGenerateMirroredCollision = false;
+	}
+
+	BodySetup->AggGeom.BoxElems.Reset(Boxes.Num());
+	LocalBounds = FBox(ForceInit);
+
+	for (const FBox& Box : Boxes)
+	{
+		const FVector Size = Box.GetSize();
+
+		FKBoxElem& Elem = BodySetup->AggGeom.BoxElems.Emplace_GetRef(Size.X, Size.Y, Size.Z);
+		Elem.Center = Box.GetCenter();
+
+		LocalBounds += Box;
+	}
+}
+
+void UDungeonCollisionComponent::ClearBoxes()
+{
+	SetBoxes(TArray<FBox>());
+}
+
+int32 UDungeonCollisionComponent::GetNumBoxes() const
+{
+	return BodySetup ? BodySetup->AggGeom.BoxElems.Num() : 0;
+}
+
+UBodySetup* UDungeonCollisionComponent::GetBodySetup()
+{
+	return BodySetup;
+}
+
+FBoxSphereBounds UDungeonCollisionComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+	if (!LocalBounds.IsValid)
+	{
+		return FBoxSphereBounds(LocalToWorld.GetLocation(), FVector::ZeroVector, 0.f);
+	}
+	return FBoxSphereBounds(LocalBounds).TransformBy(LocalToWorld);
+}
+
+void UDungeonCollisionComponent::RebuildPhysicsState()
+{
+	//Boxes are analytic shapes, nothing to cook. Dropping the old instance data is enough
+	BodySetup->InvalidatePhysicsData();
+	BodySetup->CreatePhysicsMeshes();
+
+	UpdateBounds();
+	RecreatePhysicsState();
+}
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/PrimitiveComponent.h"
+#include "DungeonCollisionComponent.generated.h"
+
+class UBodySetup;
+
+//Collision for a whole generated floor as one body made of simple box primitives.
+//Has no render data, pair it with instanced or merged meshes that have collision disabled
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class PROCEDURALDUNGEON4_API UDungeonCollisionComponent : public UPrimitiveComponent
+{
+	GENERATED_BODY()
+
+public:
+	UDungeonCollisionComponent();
+
+	//Replace every box and rebuild the body. Boxes are in component space
+	void SetBoxes(const TArray<FBox>& InBoxes);
+
+	UFUNCTION(BlueprintCallable, Category = "Dungeon|Collision")
+	void ClearBoxes();
+
+	UFUNCTION(BlueprintCallable, Category = "Dungeon|Collision")
+	int32 GetNumBoxes() const;
+
+	//~ Begin UActorComponent Interface
+	virtual void OnRegister() override;
+	//~ End UActorComponent Interface
+
+	//~ Begin UPrimitiveComponent Interface
+	virtual UBodySetup* GetBodySetup() override;
+	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+	//~ End UPrimitiveComponent Interface
+
+private:
+	//Saved, so a baked level gets its collision back without regenerating
+	UPROPERTY()
+	TArray<FBox> Boxes;
+
+	//Built from Boxes, transient - never saved or cooked
+	UPROPERTY(Transient)
+	TObjectPtr<UBodySetup> BodySetup;
+
+	//Union of all boxes, in component space
+	FBox LocalBounds;
+
+	//Fill BodySetup and LocalBounds from Boxes
+	void BuildBodySetup();
+
+	void RebuildPhysicsState();
+};
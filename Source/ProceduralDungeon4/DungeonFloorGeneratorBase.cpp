@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DungeonFloorGeneratorBase.h"
+#include "DungeonStats.h"
+#include "DungeonMemory.h"
+#include "DungeonBake.h"
+#include "Net/UnrealNetwork.h"
+
+// Sets default values
+ADungeonFloorGeneratorBase::ADungeonFloorGeneratorBase()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	//Only the generation descriptor replicates, see bReplicateGeneration
+	bReplicates = true;
+	bAlwaysRelevant = true;
+}
+
+// Called when the game starts or when spawned
+void ADungeonFloorGeneratorBase::BeginPlay()
+{
+	Super::BeginPlay();
+
+	//Geometry is saved in the level already
+	if (bBakedLayout) return;
+
+	if (bReplicateGeneration && !HasAuthority())
+	{
+		//Clients build from the server's descriptor, which may have arrived before BeginPlay
+		if (GenerationDescriptor.IsSet())
+		{
+			ApplyGenerationDescriptor();
+		}
+		return;
+	}
+
+	GenerateAndSpawn(bGenerateAsync);
+}
+
+void ADungeonFloorGeneratorBase::GenerateAndSpawn(bool bAsync)
+{
+	if (bAsync)
+	{
+		GenerateLayoutAsync(true);
+		return;
+	}
+
+	GenerateLayout();
+	SpawnGeometry();
+}
+
+void ADungeonFloorGeneratorBase::GenerateLayoutAsync(bool bSpawnWhenReady)
+{
+	GenerateLayoutInBackground([this, bSpawnWhenReady](FDungeonGrid&& Result)
+		{
+			if (bSpawnWhenReady)
+			{
+				SpawnLayout(Result);
+			}
+			OnLayoutReady.Broadcast(Result);
+		});
+}
+
+void ADungeonFloorGeneratorBase::SpawnLayout(const FDungeonGrid& InLayout)
+{
+	DUNGEON_LLM_SCOPE(Grid);
+
+	if (!InLayout.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s: SpawnLayout called with an empty layout."), *GetClass()->GetName());
+		return;
+	}
+
+	Layout = InLayout;
+	SpawnGeometry();
+}
+
+void ADungeonFloorGeneratorBase::Regenerate(int32 NewSeed)
+{
+	if (bReplicateGeneration && !HasAuthority())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s: can only Regenerate on the server while bReplicateGeneration is set"), *GetName());
+		return;
+	}
+
+	if (NewSeed >= 0)
+	{
+		Seed = NewSeed;
+	}
+
+	GenerateAndSpawn(false);
+
+	UE_LOG(LogTemp, Log, TEXT("%s: regenerated with seed %d, %d actors reused, %d spawned"),
+		*GetClass()->GetName(), Layout.Seed, ActorPool.NumReused, ActorPool.NumSpawned);
+}
+
+void ADungeonFloorGeneratorBase::BakeIntoLevel()
+{
+	if (!PrepareBake()) return;
+
+	Seed = DungeonGrid::ResolveSeed(Seed);
+
+	Regenerate(Seed);
+	bBakedLayout = true;
+
+	DungeonBake::FinishBake(this, ActorPool);
+}
+
+FDungeonSeedSearchResult ADungeonFloorGeneratorBase::FindBestSeeds(const FDungeonSeedConstraints& Constraints, int32 NumSeeds, int32 NumBest, int32 FirstSeed) const
+{
+	return SearchSeeds(Constraints, NumSeeds, NumBest, FirstSeed);
+}
+
+void ADungeonFloorGeneratorBase::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ThisClass, GenerationDescriptor);
+}
+
+void ADungeonFloorGeneratorBase::OnRep_GenerationDescriptor()
+{
+	//Nothing can be spawned before BeginPlay, which applies a descriptor that arrived early itself
+	if (bReplicateGeneration && HasActorBegunPlay())
+	{
+		ApplyGenerationDescriptor();
+	}
+}
+
+void ADungeonFloorGeneratorBase::RecordTelemetry(double SpawnStartSeconds)
+{
+	FDungeonGenerationTelemetry Telemetry = DungeonTelemetry::FromSpawnPass(GetGeneratorName(), Layout, SpawnStartSeconds, ActorPool);
+	AddTelemetryDetails(Telemetry);
+	LastTelemetry = Telemetry;
+
+	FDungeonMemoryUsage Usage;
+	GetMemoryUsage(Usage);
+	DungeonMemory::CheckBudget(this, Usage);
+
+	if (bWriteTelemetryCSV)
+	{
+		DungeonTelemetry::AppendToCSV(Telemetry);
+	}
+}
+
+void ADungeonFloorGeneratorBase::GetMemoryUsage(FDungeonMemoryUsage& Out) const
+{
+	Out.GridBytes += Layout.GetAllocatedSize();
+	Out.Actors += ActorPool.NumActive();
+}
+
+uint64 ADungeonFloorGeneratorBase::GetLayoutHash() const
+{
+	return Layout.ComputeLayoutHash();
+}
@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "DungeonGrid.h"
+#include "DungeonActorPool.h"
+#include "DungeonTelemetry.h"
+#include "DungeonSeedSearch.h"
+#include "DungeonReplication.h"
+#include "DungeonFloorGeneratorBase.generated.h"
+
+class UStaticMesh;
+struct FDungeonMemoryUsage;
+
+//Everything the grid based floor generators share: seed, pooled actors, replication of the generation descriptor,
+//baking, seed search, telemetry and the layout hash. Subclasses own their settings and layout builder and
+//only fill in the builder hooks below
+UCLASS(Abstract)
+class PROCEDURALDUNGEON4_API ADungeonFloorGeneratorBase : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ADungeonFloorGeneratorBase();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	//Random seed, -1 = new seed every run
+	UPROPERTY(EditAnywhere, Category = "Dungeon")
+	int32 Seed = -1;
+
+	//Mesh used for floor tiles
+	UPROPERTY(EditAnywhere, Category = "Meshes")
+	UStaticMesh* FloorMesh = nullptr;
+
+	//Mesh used for walls
+	UPROPERTY(EditAnywhere, Category = "Meshes")
+	UStaticMesh* WallMesh = nullptr;
+
+	//Run the logical phase on a worker thread in BeginPlay and spawn once it finishes
+	UPROPERTY(EditAnywhere, Category = "Async")
+	bool bGenerateAsync = false;
+
+	// ---- Replication ----
+
+	//Clients rebuild the server's layout from a replicated descriptor instead of receiving geometry, see DungeonReplication
+	UPROPERTY(EditAnywhere, Category = "Replication")
+	bool bReplicateGeneration = true;
+
+	// ---- Bake ----
+
+	//Geometry was baked into the level by BakeIntoLevel, BeginPlay generates nothing
+	UPROPERTY(VisibleAnywhere, Category = "Bake")
+	bool bBakedLayout = false;
+
+	// ---- Telemetry ----
+
+	//What the last spawn pass produced and cost
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	FDungeonGenerationTelemetry LastTelemetry;
+
+	//Also append LastTelemetry to Saved/Telemetry/DungeonGeneration.csv after every spawn pass
+	UPROPERTY(EditAnywhere, Category = "Telemetry")
+	bool bWriteTelemetryCSV = false;
+
+	//Fired on the game thread when an async layout has finished generating
+	UPROPERTY(BlueprintAssignable, Category = "Async")
+	FOnDungeonLayoutReady OnLayoutReady;
+
+	//Mesh actors of the spawn passes, reused across Regenerate. Saved with a baked level
+	UPROPERTY()
+	FDungeonActorPool ActorPool;
+
+	//Generate the layout on a worker thread. Spawning always happens back on the game thread,
+	//either right away (bSpawnWhenReady) or later through SpawnLayout
+	UFUNCTION(BlueprintCallable, Category = "Async")
+	void GenerateLayoutAsync(bool bSpawnWhenReady = true);
+
+	//Spawn geometry for a layout generated earlier, e.g. one pre-generated for the next floor
+	UFUNCTION(BlueprintCallable, Category = "Async")
+	void SpawnLayout(const FDungeonGrid& InLayout);
+
+	//Rebuild in place, reusing the spawned actors. NewSeed >= 0 replaces Seed, -1 keeps the Seed setting.
+	//While generation replicates only the server regenerates, clients follow the descriptor
+	UFUNCTION(BlueprintCallable, Category = "Dungeon")
+	void Regenerate(int32 NewSeed = -1);
+
+	//Resolve Seed and keep it so the bake can be reproduced, regenerate through the usual spawn pass, mark the layout
+	//baked and turn the result into Static level content, see DungeonBake::FinishBake. Save the level afterwards
+	UFUNCTION(CallInEditor, Category = "Bake")
+	void BakeIntoLevel();
+
+	//NumBest of NumSeeds seeds that fit Constraints, logical phase only, see DungeonSeedSearch::Search
+	UFUNCTION(BlueprintCallable, Category = "Dungeon")
+	FDungeonSeedSearchResult FindBestSeeds(const FDungeonSeedConstraints& Constraints, int32 NumSeeds = 1000, int32 NumBest = 10, int32 FirstSeed = 0) const;
+
+	//What this generator keeps alive after generation, for Dungeon.MemReport and the memory budget
+	virtual void GetMemoryUsage(FDungeonMemoryUsage& Out) const;
+
+	//Layout.ComputeLayoutHash, see -run=DungeonBenchmark -VerifyGoldens
+	uint64 GetLayoutHash() const;
+
+	//GetLayoutHash as 16 hex digits
+	UFUNCTION(BlueprintPure, Category = "Dungeon")
+	FString GetLayoutHashString() const { return DungeonGrid::LayoutHashToString(GetLayoutHash()); }
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	//Logical result of the last generation
+	FDungeonGrid Layout;
+
+	//What clients rebuild the current layout from, set by the server on every spawn pass
+	UPROPERTY(ReplicatedUsing = OnRep_GenerationDescriptor)
+	FDungeonGenerationDescriptor GenerationDescriptor;
+
+	UFUNCTION()
+	void OnRep_GenerationDescriptor();
+
+	//End of a spawn pass: keep the telemetry as LastTelemetry, check the memory budget and
+	//append the CSV row if bWriteTelemetryCSV is set
+	void RecordTelemetry(double SpawnStartSeconds);
+
+	// ---- Builder hooks ----
+
+	//Generator name in descriptors, telemetry and seed search results, e.g. "CA"
+	virtual const TCHAR* GetGeneratorName() const PURE_VIRTUAL(ADungeonFloorGeneratorBase::GetGeneratorName, return TEXT(""););
+
+	//Fill Layout from the current settings on the game thread
+	virtual void GenerateLayout() PURE_VIRTUAL(ADungeonFloorGeneratorBase::GenerateLayout, );
+
+	//Run the builder over the current settings on a worker thread and hand its grid to OnBuilt on the game thread
+	virtual void GenerateLayoutInBackground(TUniqueFunction<void(FDungeonGrid&&)>&& OnBuilt) PURE_VIRTUAL(ADungeonFloorGeneratorBase::GenerateLayoutInBackground, );
+
+	//Server side, see DungeonReplication::UpdateDescriptor
+	virtual void UpdateGenerationDescriptor() PURE_VIRTUAL(ADungeonFloorGeneratorBase::UpdateGenerationDescriptor, );
+
+	//Client side, see DungeonReplication::BuildFromDescriptor
+	virtual void ApplyGenerationDescriptor() PURE_VIRTUAL(ADungeonFloorGeneratorBase::ApplyGenerationDescriptor, );
+
+	//FindBestSeeds over the current settings, see DungeonSeedSearch::SearchBuilder
+	virtual FDungeonSeedSearchResult SearchSeeds(const FDungeonSeedConstraints& Constraints, int32 NumSeeds, int32 NumBest, int32 FirstSeed) const
+		PURE_VIRTUAL(ADungeonFloorGeneratorBase::SearchSeeds, return FDungeonSeedSearchResult(););
+
+	//Spawn pass for Layout. Calls UpdateGenerationDescriptor first and RecordTelemetry last
+	virtual void SpawnGeometry() PURE_VIRTUAL(ADungeonFloorGeneratorBase::SpawnGeometry, );
+
+	//Server side generation in BeginPlay (bAsync = bGenerateAsync) and Regenerate (never async)
+	virtual void GenerateAndSpawn(bool bAsync);
+
+	//Generator specific part of the telemetry, e.g. its parameters
+	virtual void AddTelemetryDetails(FDungeonGenerationTelemetry& Telemetry) const {}
+
+	//Last chance to refuse or adjust a bake before it regenerates. False cancels it
+	virtual bool PrepareBake() { return true; }
+};
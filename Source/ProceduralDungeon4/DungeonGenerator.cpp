@@ -2,12 +2,152 @@
 
 
 #include "DungeonGenerator.h"
+#include "DungeonRoom.h"
+#include "DungeonGrid.h"
+#include "RoomGenerator.h"
+#include "TileOccupancy.h"
+#include "Engine/World.h"
+#include "Engine/StaticMesh.h"
+#include "Async/ParallelFor.h"
+#include "UObject/ConstructorHelpers.h"
+
+namespace
+{
+	//One room-growth job. Coords are room-local until placement fills in Offset
+	struct FRoomJob
+	{
+		TArray<FIntPoint> Coords;
+		FIntRect Bounds;
+		FIntPoint Offset = FIntPoint::ZeroValue;
+
+		//Room this one was placed against and gets a corridor to
+		int32 Anchor = INDEX_NONE;
+
+		FIntRect PlacedBounds() const { return FIntRect(Bounds.Min + Offset, Bounds.Max + Offset); }
+	};
+
+	FORCEINLINE int32 FloorDiv(int32 A, int32 B)
+	{
+		return (A >= 0) ? A / B : ((A + 1) / B) - 1;
+	}
+
+	//Uniform hash grid over placed room bounds, so an overlap test only looks at nearby rooms
+	struct FRoomPlacementIndex
+	{
+		explicit FRoomPlacementIndex(int32 InBucketSize)
+			: BucketSize(FMath::Max(1, InBucketSize))
+		{}
+
+		void Add(const FIntRect& Rect)
+		{
+			const int32 RectIndex = Rects.Add(Rect);
+			ForEachBucket(Rect, [&](const FIntPoint& Bucket)
+			{
+				Buckets.FindOrAdd(Bucket).Add(RectIndex);
+			});
+		}
+
+		//True if Rect intersects any stored rect (max edges are exclusive)
+		bool Overlaps(const FIntRect& Rect) const
+		{
+			bool bOverlaps = false;
+			ForEachBucket(Rect, [&](const FIntPoint& Bucket)
+			{
+				if (bOverlaps) return;
+				if (const TArray<int32>* Entries = Buckets.Find(Bucket))
+				{
+					for (const int32 Other : *Entries)
+					{
+						const FIntRect& O = Rects[Other];
+						if (Rect.Min.X < O.Max.X && O.Min.X < Rect.Max.X && Rect.Min.Y < O.Max.Y && O.Min.Y < Rect.Max.Y)
+						{
+							bOverlaps = true;
+							return;
+						}
+					}
+				}
+			});
+			return bOverlaps;
+		}
+
+	private:
+		template<typename FuncType>
+		void ForEachBucket(const FIntRect& Rect, FuncType&& Func) const
+		{
+			const int32 MinBX = FloorDiv(Rect.Min.X, BucketSize);
+			const int32 MinBY = FloorDiv(Rect.Min.Y, BucketSize);
+			const int32 MaxBX = FloorDiv(Rect.Max.X - 1, BucketSize);
+			const int32 MaxBY = FloorDiv(Rect.Max.Y - 1, BucketSize);
+
+			for (int32 by = MinBY; by <= MaxBY; ++by)
+			{
+				for (int32 bx = MinBX; bx <= MaxBX; ++bx)
+				{
+					Func(FIntPoint(bx, by));
+				}
+			}
+		}
+
+		int32 BucketSize;
+		TArray<FIntRect> Rects;
+		TMap<FIntPoint, TArray<int32>> Buckets;
+	};
+
+	//Min corner for a room of Size placed on side Dir (0 = +X, 1 = -X, 2 = +Y, 3 = -Y) of Anchor, Gap tiles away.
+	//Distance scales how many room-lengths further out to push it
+	FIntPoint PlaceBeside(const FIntRect& Anchor, const FIntPoint& Size, int32 Dir, int32 Gap, int32 Distance, FRandomStream& Rng)
+	{
+		const int32 AlongX = Rng.RandRange(Anchor.Min.X - Size.X + 1, Anchor.Max.X - 1);
+		const int32 AlongY = Rng.RandRange(Anchor.Min.Y - Size.Y + 1, Anchor.Max.Y - 1);
+		const int32 PushX = Distance * (Size.X + Gap);
+		const int32 PushY = Distance * (Size.Y + Gap);
+
+		switch (Dir)
+		{
+			case 0:  return FIntPoint(Anchor.Max.X + Gap + PushX, AlongY);
+			case 1:  return FIntPoint(Anchor.Min.X - Gap - Size.X - PushX, AlongY);
+			case 2:  return FIntPoint(AlongX, Anchor.Max.Y + Gap + PushY);
+			default: return FIntPoint(AlongX, Anchor.Min.Y - Gap - Size.Y - PushY);
+		}
+	}
+
+	//Tile of Coords closest to Target
+	FIntPoint ClosestTile(const TArray<FIntPoint>& Coords, const FIntPoint& Offset, const FIntPoint& Target)
+	{
+		FIntPoint Best = Coords[0] + Offset;
+		int32 BestDist = TNumericLimits<int32>::Max();
+		for (const FIntPoint& C : Coords)
+		{
+			const FIntPoint P = C + Offset;
+			const int32 Dist = FMath::Abs(P.X - Target.X) + FMath::Abs(P.Y - Target.Y);
+			if (Dist < BestDist)
+			{
+				BestDist = Dist;
+				Best = P;
+			}
+		}
+		return Best;
+	}
+
+	float MsSince(double StartSeconds)
+	{
+		return (float)((FPlatformTime::Seconds() - StartSeconds) * 1000.0);
+	}
+}
 
 // Sets default values
 ADungeonGenerator::ADungeonGenerator()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> PlaneAsset(TEXT("/Engine/BasicShapes/Plane"));
+	if (PlaneAsset.Succeeded())
+	{
+		TileMesh = PlaneAsset.Object;
+	}
 
 }
 
@@ -15,7 +155,12 @@ ADungeonGenerator::ADungeonGenerator()
 void ADungeonGenerator::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	if (bGenerateOnBeginPlay)
+	{
+		GenerateDungeon();
+	}
+
 }
 
 // Called every frame
@@ -25,3 +170,243 @@ void ADungeonGenerator::Tick(float DeltaTime)
 
 }
 
+void ADungeonGenerator::GenerateDungeon()
+{
+	UWorld* World = GetWorld();
+	if (!World || !DungeonRoomClass || NumRooms <= 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("DungeonGenerator: DungeonRoomClass not assigned or NumRooms <= 0 in %s"), *GetName());
+		return;
+	}
+
+	UTileOccupancySubsystem* Occupancy = World->GetSubsystem<UTileOccupancySubsystem>();
+	if (!Occupancy) return;
+
+	//A second call replaces the dungeon, and the old rooms' tiles have to be free before placement checks them
+	DestroyDungeon();
+
+	const double StartTime = FPlatformTime::Seconds();
+	const int32 DungeonSeed = DungeonGrid::ResolveSeed(Seed);
+	const int32 MinTiles = FMath::Max(1, MinTilesPerRoom);
+	const int32 MaxTiles = FMath::Max(MinTiles, MaxTilesPerRoom);
+	const int32 Gap = FMath::Max(1, RoomSpacing);
+	const FIntPoint GapPadding(Gap, Gap);
+
+	//---- Room layouts, one job per room ----
+
+	double PhaseStart = FPlatformTime::Seconds();
+
+	TArray<FRoomJob> Jobs;
+	Jobs.SetNum(NumRooms);
+
+	//Every job has its own stream and occupancy grid, so results don't depend on scheduling
+	ParallelFor(NumRooms, [&](int32 i)
+	{
+		FRoomJob& Job = Jobs[i];
+		FRandomStream Rng((int32)HashCombine(GetTypeHash(DungeonSeed), GetTypeHash(i)));
+
+		FTileOccupancyGrid LocalTiles;
+		ARoomGenerator::GrowRoomLayout(Rng.RandRange(MinTiles, MaxTiles), FIntPoint::ZeroValue, Rng, LocalTiles, Job.Coords);
+
+		Job.Bounds = FIntRect(Job.Coords[0], Job.Coords[0] + FIntPoint(1, 1));
+		for (const FIntPoint& C : Job.Coords)
+		{
+			Job.Bounds.Include(C);
+			Job.Bounds.Include(C + FIntPoint(1, 1));
+		}
+	});
+
+	LastTimings.LayoutMs = MsSince(PhaseStart);
+
+	//---- Placement ----
+
+	PhaseStart = FPlatformTime::Seconds();
+
+	FRandomStream PlacementRng(DungeonSeed);
+	FRoomPlacementIndex PlacementIndex(MaxTiles);
+	const FTileOccupancyGrid& Claimed = Occupancy->GetTiles();
+	const int32 MaxAttempts = 16;
+
+	//Keeps Gap free tiles to every room of this run, and stays off tiles other generators' rooms already claimed
+	auto Fits = [&](const FRoomJob& Job, const FIntPoint& Min)
+	{
+		const FIntRect Candidate(Min, Min + Job.Bounds.Size());
+		if (PlacementIndex.Overlaps(FIntRect(Candidate.Min - GapPadding, Candidate.Max + GapPadding))) return false;
+
+		const FIntPoint Offset = Min - Job.Bounds.Min;
+		for (const FIntPoint& C : Job.Coords)
+		{
+			if (Claimed.IsOccupied(C + Offset)) return false;
+		}
+		return true;
+	};
+
+	//First room sits on the generator, or as close along +X as it fits
+	const FIntPoint OriginTile = Claimed.WorldToTile(GetActorLocation());
+	Jobs[0].Offset = OriginTile;
+	while (!Fits(Jobs[0], Jobs[0].PlacedBounds().Min))
+	{
+		Jobs[0].Offset.X += Jobs[0].Bounds.Width() + Gap;
+	}
+	PlacementIndex.Add(Jobs[0].PlacedBounds());
+
+	for (int32 i = 1; i < Jobs.Num(); ++i)
+	{
+		FRoomJob& Job = Jobs[i];
+		const FIntPoint Size = Job.Bounds.Size();
+
+		bool bPlaced = false;
+		int32 Anchor = INDEX_NONE;
+		int32 Dir = 0;
+
+		//Try to put it right next to a random earlier room
+		for (int32 Attempt = 0; Attempt < MaxAttempts && !bPlaced; ++Attempt)
+		{
+			Anchor = PlacementRng.RandRange(0, i - 1);
+			Dir = PlacementRng.RandRange(0, 3);
+
+			const FIntPoint Min = PlaceBeside(Jobs[Anchor].PlacedBounds(), Size, Dir, Gap, 0, PlacementRng);
+			if (Fits(Job, Min))
+			{
+				Job.Offset = Min - Job.Bounds.Min;
+				bPlaced = true;
+			}
+		}
+
+		//Crowded, keep pushing outward from the last anchor until there's room
+		for (int32 Distance = 1; !bPlaced; ++Distance)
+		{
+			const FIntPoint Min = PlaceBeside(Jobs[Anchor].PlacedBounds(), Size, Dir, Gap, Distance, PlacementRng);
+			if (Fits(Job, Min))
+			{
+				Job.Offset = Min - Job.Bounds.Min;
+				bPlaced = true;
+			}
+		}
+
+		Job.Anchor = Anchor;
+		PlacementIndex.Add(Job.PlacedBounds());
+	}
+
+	LastTimings.PlacementMs = MsSince(PhaseStart);
+
+	//---- Corridors, each room to the room it was placed against ----
+
+	PhaseStart = FPlatformTime::Seconds();
+
+	TSet<FIntPoint> RoomTiles;
+	for (const FRoomJob& Job : Jobs)
+	{
+		for (const FIntPoint& C : Job.Coords)
+		{
+			RoomTiles.Add(C + Job.Offset);
+		}
+	}
+
+	TArray<FIntPoint> CorridorTiles;
+	TSet<FIntPoint> CorridorSet;
+
+	for (int32 i = 1; i < Jobs.Num(); ++i)
+	{
+		const FRoomJob& Job = Jobs[i];
+		const FRoomJob& Other = Jobs[Job.Anchor];
+
+		const FIntPoint A = ClosestTile(Job.Coords, Job.Offset, Other.PlacedBounds().Min + Other.Bounds.Size() / 2);
+		const FIntPoint B = ClosestTile(Other.Coords, Other.Offset, A);
+
+		//L-shaped: walk X first, then Y
+		FIntPoint Current = A;
+		const int32 StepX = (B.X > Current.X) ? 1 : -1;
+		const int32 StepY = (B.Y > Current.Y) ? 1 : -1;
+
+		//A corridor crossing another generator's room just walks through it, that room keeps its tiles
+		auto Carve = [&](const FIntPoint& P)
+		{
+			if (!RoomTiles.Contains(P) && !CorridorSet.Contains(P) && !Claimed.IsOccupied(P))
+			{
+				CorridorSet.Add(P);
+				CorridorTiles.Add(P);
+			}
+		};
+
+		while (Current.X != B.X)
+		{
+			Carve(Current);
+			Current.X += StepX;
+		}
+		while (Current.Y != B.Y)
+		{
+			Carve(Current);
+			Current.Y += StepY;
+		}
+	}
+
+	LastTimings.CorridorMs = MsSince(PhaseStart);
+
+	//---- Spawning, game thread ----
+
+	PhaseStart = FPlatformTime::Seconds();
+
+	Rooms.Reset(Jobs.Num());
+	const FVector TileOrigin(0.f, 0.f, GetActorLocation().Z);
+	const float TileSize = Occupancy->GetTiles().TileSize;
+
+	FActorSpawnParameters Params;
+	Params.Owner = this;
+	Params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	int32 TotalTiles = 0;
+	for (const FRoomJob& Job : Jobs)
+	{
+		ADungeonRoom* Room = World->SpawnActor<ADungeonRoom>(DungeonRoomClass, FTransform::Identity, Params);
+		if (!Room) continue;
+
+		Room->Initialize(Job.Coords.Num());
+		for (const FIntPoint& C : Job.Coords)
+		{
+			Room->AddTileCoord(C + Job.Offset);
+		}
+		Room->BuildTileInstances(TileMesh, TileOrigin, TileSize);
+		Room->FindEdges();
+
+		Rooms.Add(Room);
+		TotalTiles += Job.Coords.Num();
+	}
+
+	if (CorridorTiles.Num() > 0)
+	{
+		CorridorRoom = World->SpawnActor<ADungeonRoom>(DungeonRoomClass, FTransform::Identity, Params);
+		if (CorridorRoom)
+		{
+			CorridorRoom->Initialize(CorridorTiles.Num());
+			for (const FIntPoint& C : CorridorTiles)
+			{
+				CorridorRoom->AddTileCoord(C);
+			}
+			CorridorRoom->BuildTileInstances(TileMesh, TileOrigin, TileSize);
+		}
+	}
+
+	LastTimings.SpawnMs = MsSince(PhaseStart);
+	LastTimings.TotalMs = MsSince(StartTime);
+
+	UE_LOG(LogTemp, Log, TEXT("DungeonGenerator: %d rooms, %d room tiles, %d corridor tiles (seed %d). Layout %.2f ms, placement %.2f ms, corridors %.2f ms, spawn %.2f ms, total %.2f ms."),
+		Rooms.Num(), TotalTiles, CorridorTiles.Num(), DungeonSeed,
+		LastTimings.LayoutMs, LastTimings.PlacementMs, LastTimings.CorridorMs, LastTimings.SpawnMs, LastTimings.TotalMs);
+}
+
+void ADungeonGenerator::DestroyDungeon()
+{
+	//EndPlay of each room frees its tiles in the shared occupancy
+	for (ADungeonRoom* Room : Rooms)
+	{
+		if (Room) Room->Destroy();
+	}
+	Rooms.Reset();
+
+	if (CorridorRoom)
+	{
+		CorridorRoom->Destroy();
+		CorridorRoom = nullptr;
+	}
+}
@@ -6,20 +6,96 @@
 #include "GameFramework/Actor.h"
 #include "DungeonGenerator.generated.h"
 
+class ADungeonRoom;
+
+//Wall-clock time spent in each phase of the last GenerateDungeon call
+USTRUCT(BlueprintType)
+struct FDungeonGenerationTimings
+{
+	GENERATED_BODY()
+
+	//Parallel room growth
+	UPROPERTY(BlueprintReadOnly, Category = "Dungeon")
+	float LayoutMs = 0.f;
+
+	//Non-overlapping placement through the spatial index
+	UPROPERTY(BlueprintReadOnly, Category = "Dungeon")
+	float PlacementMs = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Dungeon")
+	float CorridorMs = 0.f;
+
+	//Room actors and instances on the game thread
+	UPROPERTY(BlueprintReadOnly, Category = "Dungeon")
+	float SpawnMs = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Dungeon")
+	float TotalMs = 0.f;
+};
+
 UCLASS()
 class PROCEDURALDUNGEON4_API ADungeonGenerator : public AActor
 {
 	GENERATED_BODY()
-	
-public:	
+
+public:
 	// Sets default values for this actor's properties
 	ADungeonGenerator();
 
+	//Grow, place, connect and spawn every room in one pass. Replaces the rooms of an earlier call
+	UFUNCTION(BlueprintCallable, Category = "Dungeon")
+	void GenerateDungeon();
+
+	//Destroy Rooms and CorridorRoom, freeing their tiles
+	UFUNCTION(BlueprintCallable, Category = "Dungeon")
+	void DestroyDungeon();
+
+	UPROPERTY(BlueprintReadOnly, Category = "Dungeon")
+	FDungeonGenerationTimings LastTimings;
+
+	//Spawned rooms, in generation order
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Dungeon")
+	TArray<TObjectPtr<ADungeonRoom>> Rooms;
+
+	//Holds every corridor tile
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Dungeon")
+	TObjectPtr<ADungeonRoom> CorridorRoom;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-public:	
+	// ---- Config ----
+
+	UPROPERTY(EditAnywhere, Category = "Dungeon")
+	bool bGenerateOnBeginPlay = true;
+
+	UPROPERTY(EditAnywhere, Category = "Dungeon")
+	int32 NumRooms = 50;
+
+	//Each room gets a tile count in [MinTilesPerRoom, MaxTilesPerRoom]
+	UPROPERTY(EditAnywhere, Category = "Dungeon")
+	int32 MinTilesPerRoom = 10;
+
+	UPROPERTY(EditAnywhere, Category = "Dungeon")
+	int32 MaxTilesPerRoom = 40;
+
+	//Minimum gap in tiles between the bounds of two rooms
+	UPROPERTY(EditAnywhere, Category = "Dungeon")
+	int32 RoomSpacing = 2;
+
+	//Random seed, -1 = new seed every run
+	UPROPERTY(EditAnywhere, Category = "Dungeon")
+	int32 Seed = -1;
+
+	UPROPERTY(EditAnywhere, Category = "Spawning")
+	TSubclassOf<ADungeonRoom> DungeonRoomClass;
+
+	//Mesh for room and corridor tiles, drawn instanced
+	UPROPERTY(EditAnywhere, Category = "Spawning")
+	UStaticMesh* TileMesh;
+
+public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
@@ -0,0 +1,182 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DungeonGrid.h"
+#include "Hash/xxhash.h"
+
+void FDungeonGrid::Init(int32 InWidth, int32 InHeight, bool bFloor)
+{
+	Width = FMath::Max(0, InWidth);
+	Height = FMath::Max(0, InHeight);
+	Cells.Init(bFloor, Width * Height);
+	Rooms.Reset();
+	Corridors.Reset();
+	Doors.Reset();
+	BuildStats = FDungeonBuildStats();
+}
+
+int32 FDungeonGrid::CountFloorCells() const
+{
+	int32 Count = 0;
+	for (const bool bFloor : Cells)
+	{
+		if (bFloor) ++Count;
+	}
+	return Count;
+}
+
+uint64 FDungeonGrid::ComputeLayoutHash() const
+{
+	FXxHash64Builder Hash;
+	Hash.Update(&Width, sizeof(Width));
+	Hash.Update(&Height, sizeof(Height));
+
+	//One byte per cell already, xxHash gets through that faster than packing it into bits first
+	Hash.Update(Cells.GetData(), Cells.Num() * sizeof(bool));
+	Hash.Update(Rooms.GetData(), Rooms.Num() * sizeof(FIntRect));
+	Hash.Update(Corridors.GetData(), Corridors.Num() * sizeof(FIntRect));
+
+	//No padding to hash, and an empty array adds nothing, so layouts without doors hash as before
+	static_assert(sizeof(FDungeonDoor) == sizeof(FIntPoint) + sizeof(int32), "FDungeonDoor must not have padding");
+	Hash.Update(Doors.GetData(), Doors.Num() * sizeof(FDungeonDoor));
+	return Hash.Finalize().Hash;
+}
+
+int32 FDungeonGrid::CountRegions() const
+{
+	FMemMark Mark(FMemStack::Get());
+
+	TDungeonScratchArray<bool> Visited;
+	Visited.Init(false, Cells.Num());
+
+	TDungeonScratchArray<FIntPoint> Stack;
+	int32 NumRegions = 0;
+
+	for (int32 y = 0; y < Height; ++y)
+	{
+		for (int32 x = 0; x < Width; ++x)
+		{
+			if (!IsFloor(x, y) || Visited[Index(x, y)]) continue;
+
+			++NumRegions;
+			Visited[Index(x, y)] = true;
+			Stack.Add(FIntPoint(x, y));
+
+			while (Stack.Num() > 0)
+			{
+				const FIntPoint P = Stack.Pop();
+
+				const FIntPoint Neighbors[4] = { P + FIntPoint(1, 0), P - FIntPoint(1, 0), P + FIntPoint(0, 1), P - FIntPoint(0, 1) };
+				for (const FIntPoint& N : Neighbors)
+				{
+					if (!IsFloor(N.X, N.Y) || Visited[Index(N.X, N.Y)]) continue;
+
+					Visited[Index(N.X, N.Y)] = true;
+					Stack.Add(N);
+				}
+			}
+		}
+	}
+
+	return NumRegions;
+}
+
+void FDungeonGrid::BuildWallSpans(TArray<FDungeonWallSpan>& OutSpans) const
+{
+	//Horizontal lines y = 0..Height, a wall where the cells above and below differ
+	for (int32 y = 0; y <= Height; ++y)
+	{
+		int32 RunStart = INDEX_NONE;
+		for (int32 x = 0; x <= Width; ++x)
+		{
+			const bool bWall = x < Width && IsFloor(x, y - 1) != IsFloor(x, y);
+			if (bWall && RunStart == INDEX_NONE)
+			{
+				RunStart = x;
+			}
+			else if (!bWall && RunStart != INDEX_NONE)
+			{
+				OutSpans.Add({ FIntPoint(RunStart, y), x - RunStart, true });
+				RunStart = INDEX_NONE;
+			}
+		}
+	}
+
+	//Vertical lines x = 0..Width
+	for (int32 x = 0; x <= Width; ++x)
+	{
+		int32 RunStart = INDEX_NONE;
+		for (int32 y = 0; y <= Height; ++y)
+		{
+			const bool bWall = y < Height && IsFloor(x - 1, y) != IsFloor(x, y);
+			if (bWall && RunStart == INDEX_NONE)
+			{
+				RunStart = y;
+			}
+			else if (!bWall && RunStart != INDEX_NONE)
+			{
+				OutSpans.Add({ FIntPoint(x, RunStart), y - RunStart, false });
+				RunStart = INDEX_NONE;
+			}
+		}
+	}
+}
+
+void FDungeonGrid::BuildFloorRects(TArray<FIntRect>& OutRects) const
+{
+	DungeonGrid::MergeCellsIntoRects(Cells, Width, Height, FIntRect(0, 0, Width, Height), OutRects);
+}
+
+void DungeonGrid::MergeCellsIntoRects(TConstArrayView<bool> Mask, int32 Width, int32 Height, const FIntRect& Area, TArray<FIntRect>& OutRects)
+{
+	check(Mask.Num() == Width * Height);
+	check(Area.Min.X >= 0 && Area.Min.Y >= 0 && Area.Max.X <= Width && Area.Max.Y <= Height);
+
+	const int32 W = Area.Width();
+	const int32 H = Area.Height();
+	if (W <= 0 || H <= 0) return;
+
+	TBitArray<> Used(false, W * H);
+
+	auto IsFree = [&](int32 LX, int32 LY)
+	{
+		return !Used[LY * W + LX] && Mask[(Area.Min.Y + LY) * Width + Area.Min.X + LX];
+	};
+
+	for (int32 y = 0; y < H; ++y)
+	{
+		for (int32 x = 0; x < W; ++x)
+		{
+			if (!IsFree(x, y)) continue;
+
+			//Grow right
+			int32 EndX = x + 1;
+			while (EndX < W && IsFree(EndX, y))
+			{
+				++EndX;
+			}
+
+			//Grow down while the full run is free
+			int32 EndY = y + 1;
+			for (; EndY < H; ++EndY)
+			{
+				bool bRowFree = true;
+				for (int32 RX = x; RX < EndX && bRowFree; ++RX)
+				{
+					bRowFree = IsFree(RX, EndY);
+				}
+				if (!bRowFree) break;
+			}
+
+			for (int32 MY = y; MY < EndY; ++MY)
+			{
+				for (int32 MX = x; MX < EndX; ++MX)
+				{
+					Used[MY * W + MX] = true;
+				}
+			}
+
+			OutRects.Add(FIntRect(Area.Min.X + x, Area.Min.Y + y, Area.Min.X + EndX, Area.Min.Y + EndY));
+		}
+	}
+}
@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/MemStack.h"
+#include "DungeonGrid.generated.h"
+
+//Generation temporaries on the calling thread's FMemStack. Freed in bulk when the enclosing
+//FMemMark goes out of scope, so one must never outlive the mark it was allocated under
+template <typename T>
+using TDungeonScratchArray = TArray<T, TMemStackAllocator<>>;
+
+//Straight run of wall along one cell boundary line, in cell space.
+//bAlongX spans cells [Start.X, Start.X + Length) on the line y = Start.Y, otherwise
+//cells [Start.Y, Start.Y + Length) on the line x = Start.X
+struct FDungeonWallSpan
+{
+	FIntPoint Start = FIntPoint::ZeroValue;
+	int32 Length = 0;
+	bool bAlongX = true;
+};
+
+//Cell edge a builder turned into a door, in cell space
+struct FDungeonDoor
+{
+	FIntPoint Cell = FIntPoint::ZeroValue;
+
+	//Edge of Cell: 0 = East, 1 = West, 2 = North, 3 = South
+	int32 Direction = 0;
+
+	bool operator==(const FDungeonDoor& Other) const { return Cell == Other.Cell && Direction == Other.Direction; }
+};
+
+//What building a grid cost and produced besides the cells, filled in by the layout builder
+struct FDungeonBuildStats
+{
+	//Time spent in the builder, on whichever thread ran it
+	float BuildMs = 0.f;
+
+	//Cells turned into floor by corridor carving
+	int32 CorridorCells = 0;
+
+	//Most scratch memory (maps, labels, frontiers, trees) the builder held at once
+	int64 PeakTempBytes = 0;
+
+	void NoteTempBytes(int64 Bytes) { PeakTempBytes = FMath::Max(PeakTempBytes, Bytes); }
+};
+
+//Logical output of a floor generator. Plain data with no world references,
+//so it can be produced on a worker thread and spawned later on the game thread
+USTRUCT(BlueprintType)
+struct FDungeonGrid
+{
+	GENERATED_BODY()
+
+	//Dimensions of the grid in cells
+	UPROPERTY(BlueprintReadOnly, Category = "Dungeon")
+	int32 Width = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Dungeon")
+	int32 Height = 0;
+
+	//Seed the layout was generated with (always resolved, never -1)
+	UPROPERTY(BlueprintReadOnly, Category = "Dungeon")
+	int32 Seed = 0;
+
+	//true = floor, false = wall / empty
+	UPROPERTY(BlueprintReadOnly, Category = "Dungeon")
+	TArray<bool> Cells;
+
+	//Room rectangles in cell space, for generators that place rooms (BSP)
+	TArray<FIntRect> Rooms;
+
+	//Corridor floor that isn't part of a room, as non-overlapping rectangles
+	TArray<FIntRect> Corridors;
+
+	//Doors in the order they were picked, for generators that place doors (Holmquist)
+	TArray<FDungeonDoor> Doors;
+
+	//Reset by Init, the builder fills it while generating
+	FDungeonBuildStats BuildStats;
+
+	//Resize and fill every cell with bFloor
+	void Init(int32 InWidth, int32 InHeight, bool bFloor);
+
+	FORCEINLINE int32 Index(int32 X, int32 Y) const
+	{
+		return Y * Width + X;
+	}
+
+	FORCEINLINE bool IsInBounds(int32 X, int32 Y) const
+	{
+		return X >= 0 && Y >= 0 && X < Width && Y < Height;
+	}
+
+	//Out of bounds counts as not floor
+	FORCEINLINE bool IsFloor(int32 X, int32 Y) const
+	{
+		return IsInBounds(X, Y) && Cells[Index(X, Y)];
+	}
+
+	FORCEINLINE void SetFloor(int32 X, int32 Y, bool bFloor)
+	{
+		Cells[Index(X, Y)] = bFloor;
+	}
+
+	bool IsValid() const { return Width > 0 && Height > 0 && Cells.Num() == Width * Height; }
+
+	int32 CountFloorCells() const;
+
+	//Number of 4-connected floor regions
+	int32 CountRegions() const;
+
+	//64-bit hash of the dimensions, cells, room and corridor rectangles and doors. Equal on two machines or two builds means the same layout
+	uint64 ComputeLayoutHash() const;
+
+	//Heap memory held by Cells, Rooms, Corridors and Doors
+	SIZE_T GetAllocatedSize() const
+	{
+		return Cells.GetAllocatedSize() + Rooms.GetAllocatedSize() + Corridors.GetAllocatedSize() + Doors.GetAllocatedSize();
+	}
+
+	//Every boundary between a floor cell and a non-floor cell, merged into maximal straight runs.
+	//Openings where two floor cells meet (e.g. a corridor entering a room) get no wall
+	void BuildWallSpans(TArray<FDungeonWallSpan>& OutSpans) const;
+
+	//All floor cells as non-overlapping rectangles, see DungeonGrid::MergeCellsIntoRects
+	void BuildFloorRects(TArray<FIntRect>& OutRects) const;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnDungeonLayoutReady, const FDungeonGrid&, Layout);
+
+namespace DungeonGrid
+{
+	//Seed >= 0 is used as-is, anything negative picks a fresh random seed.
+	//Call on the game thread before handing settings to a worker
+	inline int32 ResolveSeed(int32 Seed)
+	{
+		return Seed >= 0 ? Seed : FMath::Rand();
+	}
+
+	//Greedy meshing: cover the set cells of a Width x Height mask inside Area with as few rectangles as possible.
+	//Each rect grows right as far as it can, then down while the whole row below is set and not yet covered
+	void MergeCellsIntoRects(TConstArrayView<bool> Mask, int32 Width, int32 Height, const FIntRect& Area, TArray<FIntRect>& OutRects);
+
+	//Layout hash as 16 hex digits, for logs, goldens and Blueprint
+	inline FString LayoutHashToString(uint64 Hash)
+	{
+		return FString::Printf(TEXT("%016llx"), Hash);
+	}
+}
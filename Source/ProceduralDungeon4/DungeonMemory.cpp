@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DungeonMemory.h"
+#include "DungeonFloorGeneratorBase.h"
+#include "DungeonRoom.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+
+LLM_DEFINE_TAG(Dungeon);
+LLM_DEFINE_TAG(Dungeon_Grid);
+LLM_DEFINE_TAG(Dungeon_WallSegments);
+LLM_DEFINE_TAG(Dungeon_RoomTiles);
+LLM_DEFINE_TAG(Dungeon_Actors);
+LLM_DEFINE_TAG(Dungeon_Temp);
+
+static TAutoConsoleVariable<int32> CVarDungeonMemoryBudgetKB(
+	TEXT("Dungeon.MemoryBudgetKB"),
+	0,
+	TEXT("Per generator budget for the memory it keeps after generation, in KB. 0 = no budget"));
+
+bool DungeonMemory::CheckBudget(const UObject* Owner, const FDungeonMemoryUsage& Usage)
+{
+	const int64 BudgetBytes = (int64)CVarDungeonMemoryBudgetKB.GetValueOnGameThread() * 1024;
+	if (BudgetBytes <= 0 || Usage.TotalBytes() <= BudgetBytes) return true;
+
+	UE_LOG(LogTemp, Warning, TEXT("DungeonMemory: %s uses %lld KB, budget is %lld KB (grid %lld, wall segments %lld, room tiles %lld bytes)"),
+		*GetNameSafe(Owner), Usage.TotalBytes() / 1024, BudgetBytes / 1024, Usage.GridBytes, Usage.WallSegmentBytes, Usage.RoomTileBytes);
+	return false;
+}
+
+namespace
+{
+	template <typename TActor>
+	void ReportActors(UWorld* World, FDungeonMemoryUsage& Total)
+	{
+		for (TActorIterator<TActor> It(World); It; ++It)
+		{
+			FDungeonMemoryUsage Usage;
+			It->GetMemoryUsage(Usage);
+			Total += Usage;
+
+			UE_LOG(LogTemp, Display, TEXT("  %-40s %8lld KB  grid %lld  walls %lld  tiles %lld  actors %d  instances %d%s"),
+				*It->GetName(), Usage.TotalBytes() / 1024, Usage.GridBytes, Usage.WallSegmentBytes, Usage.RoomTileBytes,
+				Usage.Actors, Usage.Instances, DungeonMemory::CheckBudget(*It, Usage) ? TEXT("") : TEXT("  OVER BUDGET"));
+		}
+	}
+
+	void DumpMemoryReport(UWorld* World)
+	{
+		if (!World) return;
+
+		UE_LOG(LogTemp, Display, TEXT("DungeonMemory: report for %s (full LLM breakdown: stat LLMFULL, Dungeon/ tags)"), *World->GetName());
+
+		FDungeonMemoryUsage Total;
+		ReportActors<ADungeonFloorGeneratorBase>(World, Total);
+		ReportActors<ADungeonRoom>(World, Total);
+
+		UE_LOG(LogTemp, Display, TEXT("DungeonMemory: total %lld KB (grid %lld, wall segments %lld, room tiles %lld bytes), %d actors, %d instances"),
+			Total.TotalBytes() / 1024, Total.GridBytes, Total.WallSegmentBytes, Total.RoomTileBytes, Total.Actors, Total.Instances);
+	}
+}
+
+static FAutoConsoleCommandWithWorld DungeonMemReportCommand(
+	TEXT("Dungeon.MemReport"),
+	TEXT("Logs the memory every dungeon generator and room in the world keeps, checked against Dungeon.MemoryBudgetKB"),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&DumpMemoryReport));
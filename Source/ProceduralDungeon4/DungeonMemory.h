@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+
+//LLM tags for dungeon allocations, listed under Dungeon/ in "stat LLMFULL" and -llmcsv captures
+LLM_DECLARE_TAG_API(Dungeon, PROCEDURALDUNGEON4_API);
+
+//FDungeonGrid cells, room and corridor rects
+LLM_DECLARE_TAG_API(Dungeon_Grid, PROCEDURALDUNGEON4_API);
+
+//FHolmquistWallSegment arrays
+LLM_DECLARE_TAG_API(Dungeon_WallSegments, PROCEDURALDUNGEON4_API);
+
+//ADungeonRoom tile, tile data and edge arrays
+LLM_DECLARE_TAG_API(Dungeon_RoomTiles, PROCEDURALDUNGEON4_API);
+
+//Spawned mesh actors, instances and merged floor meshes
+LLM_DECLARE_TAG_API(Dungeon_Actors, PROCEDURALDUNGEON4_API);
+
+//Scratch buffers that only live for one generation: automaton maps, region labels and cell lists, frontiers, masks
+LLM_DECLARE_TAG_API(Dungeon_Temp, PROCEDURALDUNGEON4_API);
+
+//Tag allocations in the current scope, Tag is the suffix of a Dungeon_ tag above
+#define DUNGEON_LLM_SCOPE(Tag) LLM_SCOPE_BYTAG(Dungeon_##Tag)
+
+//What one generator or room keeps alive after generation, see Dungeon.MemReport
+struct FDungeonMemoryUsage
+{
+	int64 GridBytes = 0;
+	int64 WallSegmentBytes = 0;
+	int64 RoomTileBytes = 0;
+
+	//Actors and instances are counted, their memory lives in the engine
+	int32 Actors = 0;
+	int32 Instances = 0;
+
+	int64 TotalBytes() const { return GridBytes + WallSegmentBytes + RoomTileBytes; }
+
+	FDungeonMemoryUsage& operator+=(const FDungeonMemoryUsage& Other)
+	{
+		GridBytes += Other.GridBytes;
+		WallSegmentBytes += Other.WallSegmentBytes;
+		RoomTileBytes += Other.RoomTileBytes;
+		Actors += Other.Actors;
+		Instances += Other.Instances;
+		return *this;
+	}
+};
+
+namespace DungeonMemory
+{
+	//Warns when Usage is over Dungeon.MemoryBudgetKB, returns false in that case. 0 = no budget
+	bool CheckBudget(const UObject* Owner, const FDungeonMemoryUsage& Usage);
+}
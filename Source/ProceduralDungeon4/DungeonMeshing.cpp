@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DungeonMeshing.h"
+#include "DungeonMemory.h"
+#include "ProceduralMeshComponent.h"
+#include "GameFramework/Actor.h"
+
+void FDungeonMeshData::AddFloorQuad(const FIntRect& Rect, float TileSize, const FVector& CellOrigin)
+{
+	const int32 First = Vertices.Num();
+
+	const float X0 = CellOrigin.X + Rect.Min.X * TileSize;
+	const float X1 = CellOrigin.X + Rect.Max.X * TileSize;
+	const float Y0 = CellOrigin.Y + Rect.Min.Y * TileSize;
+	const float Y1 = CellOrigin.Y + Rect.Max.Y * TileSize;
+	const float Z = CellOrigin.Z;
+
+	Vertices.Add(FVector(X0, Y0, Z));
+	Vertices.Add(FVector(X1, Y0, Z));
+	Vertices.Add(FVector(X1, Y1, Z));
+	Vertices.Add(FVector(X0, Y1, Z));
+
+	const float U = Rect.Width();
+	const float V = Rect.Height();
+	UVs.Add(FVector2D(0.f, 0.f));
+	UVs.Add(FVector2D(U, 0.f));
+	UVs.Add(FVector2D(U, V));
+	UVs.Add(FVector2D(0.f, V));
+
+	for (int32 i = 0; i < 4; ++i)
+	{
+		Normals.Add(FVector::UpVector);
+	}
+
+	//Clockwise seen from above, which is front facing
+	Triangles.Append({ First, First + 1, First + 2, First, First + 2, First + 3 });
+}
+
+int32 DungeonMeshing::BuildChunkFloorMesh(const FDungeonGrid& Grid, const FIntRect& Area, float TileSize, const FVector& CellOrigin, FDungeonMeshData& OutMesh)
+{
+	TArray<FIntRect> Rects;
+	DungeonGrid::MergeCellsIntoRects(Grid.Cells, Grid.Width, Grid.Height, Area, Rects);
+
+	int32 NumCells = 0;
+	for (const FIntRect& Rect : Rects)
+	{
+		OutMesh.AddFloorQuad(Rect, TileSize, CellOrigin);
+		NumCells += Rect.Area();
+	}
+	return NumCells;
+}
+
+void DungeonMeshing::BuildFloorChunks(AActor* Owner, USceneComponent* AttachTo, const FDungeonGrid& Grid, int32 ChunkSize,
+	float TileSize, const FVector& CellOrigin, UMaterialInterface* Material,
+	TArray<TObjectPtr<UProceduralMeshComponent>>& InOutChunks)
+{
+	DUNGEON_LLM_SCOPE(Actors);
+
+	DestroyChunks(InOutChunks);
+
+	if (!Owner || !Grid.IsValid()) return;
+
+	ChunkSize = FMath::Max(1, ChunkSize);
+
+	int32 NumCells = 0;
+
+	for (int32 ChunkY = 0; ChunkY < Grid.Height; ChunkY += ChunkSize)
+	{
+		for (int32 ChunkX = 0; ChunkX < Grid.Width; ChunkX += ChunkSize)
+		{
+			const FIntRect Area(ChunkX, ChunkY, FMath::Min(ChunkX + ChunkSize, Grid.Width), FMath::Min(ChunkY + ChunkSize, Grid.Height));
+
+			FDungeonMeshData Mesh;
+			NumCells += BuildChunkFloorMesh(Grid, Area, TileSize, CellOrigin, Mesh);
+			if (Mesh.IsEmpty()) continue;
+
+			UProceduralMeshComponent* Chunk = NewObject<UProceduralMeshComponent>(Owner);
+			Chunk->SetupAttachment(AttachTo);
+			Chunk->RegisterComponent();
+			Chunk->CreateMeshSection(0, Mesh.Vertices, Mesh.Triangles, Mesh.Normals, Mesh.UVs,
+				TArray<FColor>(), TArray<FProcMeshTangent>(), true);
+			Chunk->SetMaterial(0, Material);
+
+			InOutChunks.Add(Chunk);
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("DungeonMeshing: %d floor cells merged into %d chunk meshes"), NumCells, InOutChunks.Num());
+}
+
+void DungeonMeshing::DestroyChunks(TArray<TObjectPtr<UProceduralMeshComponent>>& InOutChunks)
+{
+	for (UProceduralMeshComponent* Chunk : InOutChunks)
+	{
+		if (Chunk) Chunk->DestroyComponent();
+	}
+	InOutChunks.Reset();
+}
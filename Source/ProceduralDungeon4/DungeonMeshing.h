@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DungeonGrid.h"
+
+class AActor;
+class USceneComponent;
+class UMaterialInterface;
+class UProceduralMeshComponent;
+
+//Vertex streams for one procedural mesh section
+struct FDungeonMeshData
+{
+	TArray<FVector> Vertices;
+	TArray<int32> Triangles;
+	TArray<FVector> Normals;
+	TArray<FVector2D> UVs;
+
+	//Upward facing quad covering Rect (cell space). CellOrigin is the local position of cell (0,0)'s min corner.
+	//UVs run 0..1 per cell so tiling textures look the same as one plane per cell
+	void AddFloorQuad(const FIntRect& Rect, float TileSize, const FVector& CellOrigin);
+
+	bool IsEmpty() const { return Triangles.Num() == 0; }
+};
+
+namespace DungeonMeshing
+{
+	//Merged floor quads of one chunk, see DungeonGrid::MergeCellsIntoRects. Returns the number of floor cells covered
+	int32 BuildChunkFloorMesh(const FDungeonGrid& Grid, const FIntRect& Area, float TileSize, const FVector& CellOrigin, FDungeonMeshData& OutMesh);
+
+	//Merge Grid's floor per ChunkSize x ChunkSize chunk and build one procedural mesh per non-empty chunk,
+	//attached to AttachTo. Destroys whatever InOutChunks held before
+	void BuildFloorChunks(AActor* Owner, USceneComponent* AttachTo, const FDungeonGrid& Grid, int32 ChunkSize,
+		float TileSize, const FVector& CellOrigin, UMaterialInterface* Material,
+		TArray<TObjectPtr<UProceduralMeshComponent>>& InOutChunks);
+
+	void DestroyChunks(TArray<TObjectPtr<UProceduralMeshComponent>>& InOutChunks);
+}
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DungeonReplication.h"
+#include "UObject/Class.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+void DungeonReplication::WriteParameters(const UScriptStruct* Struct, const void* Settings, TArray<uint8>& OutBytes)
+{
+	OutBytes.Reset();
+
+	//Server and client run the same build, so untagged binary is enough and stays small
+	FMemoryWriter Writer(OutBytes);
+	Struct->SerializeBin(Writer, const_cast<void*>(Settings));
+}
+
+bool DungeonReplication::ReadParameters(const UScriptStruct* Struct, void* Settings, const TArray<uint8>& Bytes)
+{
+	if (Bytes.Num() == 0) return false;
+
+	FMemoryReader Reader(Bytes);
+	Struct->SerializeBin(Reader, Settings);
+	return !Reader.IsError() && Reader.AtEnd();
+}
+
+bool DungeonReplication::VerifyLayout(const UObject* Owner, const FDungeonGenerationDescriptor& Descriptor, const FDungeonGrid& Layout)
+{
+	if (Descriptor.LayoutHash == 0) return true;
+
+	const uint64 LocalHash = Layout.ComputeLayoutHash();
+	if (LocalHash != Descriptor.LayoutHash)
+	{
+		UE_LOG(LogTemp, Error, TEXT("DungeonReplication: %s diverged from the server, seed %d, local layout hash %s, server %s"),
+			*GetNameSafe(Owner), Descriptor.Seed, *DungeonGrid::LayoutHashToString(LocalHash), *DungeonGrid::LayoutHashToString(Descriptor.LayoutHash));
+		return false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("DungeonReplication: %s rebuilt the server layout, seed %d, hash %s"),
+		*GetNameSafe(Owner), Descriptor.Seed, *DungeonGrid::LayoutHashToString(LocalHash));
+	return true;
+}
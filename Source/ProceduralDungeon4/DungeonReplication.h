@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "DungeonGrid.h"
+#include "DungeonAsync.h"
+#include "DungeonReplication.generated.h"
+
+//Everything a client needs to rebuild the server's layout on its own: which generator, its layout settings and the seed.
+//A few dozen bytes whatever the dungeon size, the spawned geometry itself is never replicated
+USTRUCT()
+struct FDungeonGenerationDescriptor
+{
+	GENERATED_BODY()
+
+	//Generator that wrote the parameters, e.g. "CA"
+	UPROPERTY()
+	FName Generator;
+
+	UPROPERTY()
+	int32 Seed = 0;
+
+	//The generator's layout settings struct, binary serialized
+	UPROPERTY()
+	TArray<uint8> Parameters;
+
+	//FDungeonGrid::ComputeLayoutHash of the server's layout, 0 if there is no finite layout to compare (infinite chunks)
+	UPROPERTY()
+	uint64 LayoutHash = 0;
+
+	bool IsSet() const { return !Generator.IsNone(); }
+
+	//Same generator, parameters and seed, i.e. the same layout
+	bool Matches(const FDungeonGenerationDescriptor& Other) const
+	{
+		return Generator == Other.Generator && Seed == Other.Seed && Parameters == Other.Parameters && LayoutHash == Other.LayoutHash;
+	}
+};
+
+namespace DungeonReplication
+{
+	void WriteParameters(const UScriptStruct* Struct, const void* Settings, TArray<uint8>& OutBytes);
+	bool ReadParameters(const UScriptStruct* Struct, void* Settings, const TArray<uint8>& Bytes);
+
+	//Descriptor for a layout built from Settings. Layout may be nullptr when there is nothing to hash
+	template <typename SettingsType>
+	FDungeonGenerationDescriptor MakeDescriptor(FName Generator, const SettingsType& Settings, const FDungeonGrid* Layout)
+	{
+		FDungeonGenerationDescriptor Descriptor;
+		Descriptor.Generator = Generator;
+		Descriptor.Seed = Settings.Seed;
+		WriteParameters(SettingsType::StaticStruct(), &Settings, Descriptor.Parameters);
+		Descriptor.LayoutHash = Layout ? Layout->ComputeLayoutHash() : 0;
+		return Descriptor;
+	}
+
+	//Settings to rebuild the descriptor's layout with. False if it was written by a different generator or is malformed
+	template <typename SettingsType>
+	bool ReadSettings(const FDungeonGenerationDescriptor& Descriptor, FName Generator, SettingsType& OutSettings)
+	{
+		if (Descriptor.Generator != Generator || !ReadParameters(SettingsType::StaticStruct(), &OutSettings, Descriptor.Parameters))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("DungeonReplication: can't read a %s descriptor as %s settings"),
+				*Descriptor.Generator.ToString(), *Generator.ToString());
+			return false;
+		}
+
+		OutSettings.Seed = Descriptor.Seed;
+		return true;
+	}
+
+	//Compare a locally built layout with the server's. Logs an error and returns false if they diverged
+	bool VerifyLayout(const UObject* Owner, const FDungeonGenerationDescriptor& Descriptor, const FDungeonGrid& Layout);
+
+	//Server side, on every spawn pass: describe Layout for clients. Settings is the generator's configuration,
+	//its seed is replaced by the one Layout was built with since the Seed setting may be -1
+	template <typename SettingsType>
+	void UpdateDescriptor(const AActor* Owner, bool bReplicateGeneration, FName Generator, SettingsType Settings, const FDungeonGrid& Layout,
+		FDungeonGenerationDescriptor& OutDescriptor)
+	{
+		if (!bReplicateGeneration || !Owner->HasAuthority()) return;
+
+		Settings.Seed = Layout.Seed;
+		OutDescriptor = MakeDescriptor(Generator, Settings, &Layout);
+	}
+
+	//Client side: build the layout Descriptor describes from Settings (see ReadSettings), check it against the server's hash
+	//and hand the finished builder to Spawn. Build is the builder's logical phase. bAsync builds on a worker thread, drops the
+	//result if Descriptor was replaced in the meantime and fires OnLayoutReady after spawning, like GenerateLayoutAsync.
+	//Descriptor and OnLayoutReady are members of Owner, they are only touched again while Owner is alive
+	template <typename BuilderType, typename SpawnFuncType>
+	void BuildFromDescriptor(AActor* Owner, const FDungeonGenerationDescriptor& Descriptor, const decltype(BuilderType::Settings)& Settings,
+		void (BuilderType::*Build)(), bool bAsync, const FOnDungeonLayoutReady& OnLayoutReady, SpawnFuncType&& Spawn)
+	{
+		if (!bAsync)
+		{
+			BuilderType Builder(Settings);
+			(Builder.*Build)();
+			VerifyLayout(Owner, Descriptor, Builder.Grid);
+			Spawn(Builder);
+			return;
+		}
+
+		DungeonAsync::LaunchLayoutTask(Owner,
+			[Builder = BuilderType(Settings), Build]() mutable
+			{
+				(Builder.*Build)();
+				return MoveTemp(Builder);
+			},
+			[Owner, &Descriptor, &OnLayoutReady, Snapshot = Descriptor, Spawn = Forward<SpawnFuncType>(Spawn)](BuilderType&& Result) mutable
+			{
+				//Superseded by a newer descriptor while building
+				if (!Descriptor.Matches(Snapshot)) return;
+
+				VerifyLayout(Owner, Snapshot, Result.Grid);
+				Spawn(Result);
+				OnLayoutReady.Broadcast(Result.Grid);
+			});
+	}
+}
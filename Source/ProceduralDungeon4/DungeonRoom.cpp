@@ -4,17 +4,28 @@
 #include "DungeonRoom.h"
 #include "GridSpace.h"
 #include "Components/StaticMeshComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
 #include "Materials/MaterialInterface.h"
+#include "Engine/World.h"
+#include "TileOccupancy.h"
+#include "DungeonMemory.h"
 
 // Sets default values
 ADungeonRoom::ADungeonRoom()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	//Edges are found once when generation completes, nothing to do per frame
+	PrimaryActorTick.bCanEverTick = false;
 
 	Root = CreateDefaultSubobject<USceneComponent>("Root");
 	SetRootComponent(Root);
 
+	TileInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>("TileInstances");
+	TileInstances->SetupAttachment(Root);
+	//Rooms of AGridSpace actors never use it, collision is turned on by BuildTileInstances
+	TileInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	TileInstances->NumCustomDataFloats = 1;
+
 }
 
 void ADungeonRoom::Initialize(int32 InNumTiles)
@@ -29,31 +40,103 @@ void ADungeonRoom::BeginPlay()
 	
 }
 
-// Called every frame
-void ADungeonRoom::Tick(float DeltaTime)
+void ADungeonRoom::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
-	if (!FoundEdges)
+	UWorld* World = GetWorld();
+	if (UTileOccupancySubsystem* Occupancy = World ? World->GetSubsystem<UTileOccupancySubsystem>() : nullptr)
 	{
-		FindEdges();
+		FTileOccupancyGrid& Occupied = Occupancy->GetTiles();
+		for (const AGridSpace* T : Tiles)
+		{
+			if (T) Occupied.Remove(Occupied.WorldToTile(T->GetActorLocation()));
+		}
+		for (const FRoomTile& T : TileData)
+		{
+			Occupied.Remove(T.Coord);
+		}
 	}
 
+	Super::EndPlay(EndPlayReason);
 }
 
 void ADungeonRoom::AddTile(AGridSpace* Tile)
 {
+	DUNGEON_LLM_SCOPE(RoomTiles);
+
 	if (!Tile) return;
 
 	Tiles.Add(Tile);
 
+	//Keep the shared occupancy in sync, tiles can be added without going through ARoomGenerator
+	if (UTileOccupancySubsystem* Occupancy = GetWorld()->GetSubsystem<UTileOccupancySubsystem>())
+	{
+		FTileOccupancyGrid& Occupied = Occupancy->GetTiles();
+		Occupied.Add(Occupied.WorldToTile(Tile->GetActorLocation()));
+	}
+
 	//Group in the world for easy transform/visibility
 	Tile->AttachToActor(this, FAttachmentTransformRules::KeepWorldTransform);
 
 	Tile->SetOwner(this);
 }
 
+void ADungeonRoom::AddTileCoord(const FIntPoint& Coord)
+{
+	DUNGEON_LLM_SCOPE(RoomTiles);
+
+	FRoomTile& Tile = TileData.AddDefaulted_GetRef();
+	Tile.Coord = Coord;
+
+	if (UTileOccupancySubsystem* Occupancy = GetWorld()->GetSubsystem<UTileOccupancySubsystem>())
+	{
+		Occupancy->GetTiles().Add(Coord);
+	}
+}
+
+void ADungeonRoom::BuildTileInstances(UStaticMesh* Mesh, const FVector& TileOrigin, float TileSize)
+{
+	DUNGEON_LLM_SCOPE(Actors);
+
+	if (!Mesh || !TileInstances) return;
+
+	InstanceOrigin = TileOrigin;
+	InstanceTileSize = TileSize;
+
+	TileInstances->ClearInstances();
+	TileInstances->SetStaticMesh(Mesh);
+	TileInstances->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+
+	TArray<FTransform> Transforms;
+	Transforms.Reserve(TileData.Num());
+	for (const FRoomTile& T : TileData)
+	{
+		Transforms.Add(FTransform(TileOrigin + FVector(T.Coord.X * TileSize, T.Coord.Y * TileSize, 0.f)));
+	}
+
+	//One batched add instead of a render state update per tile
+	TileInstances->AddInstances(Transforms, false, true);
+}
+
+void ADungeonRoom::GetMemoryUsage(FDungeonMemoryUsage& Out) const
+{
+	Out.RoomTileBytes += Tiles.GetAllocatedSize() + TileData.GetAllocatedSize() + EdgeTileIndices.GetAllocatedSize();
+	Out.Actors += Tiles.Num();
+	if (TileInstances) Out.Instances += TileInstances->GetInstanceCount();
+}
+
 FVector ADungeonRoom::GetCenter() const
 {
+	if (TileData.Num() > 0)
+	{
+		FVector2D Sum = FVector2D::ZeroVector;
+		for (const FRoomTile& T : TileData)
+		{
+			Sum += FVector2D(T.Coord);
+		}
+		Sum /= TileData.Num();
+		return InstanceOrigin + FVector(Sum.X * InstanceTileSize, Sum.Y * InstanceTileSize, 0.f);
+	}
+
 	if (Tiles.Num() == 0) return FVector::ZeroVector;
 
 	FVector Sum = FVector::ZeroVector;
@@ -66,34 +149,78 @@ FVector ADungeonRoom::GetCenter() const
 
 void ADungeonRoom::FindEdges()
 {
-	TArray<TObjectPtr<AGridSpace>> EdgeSpaces;
+	DUNGEON_LLM_SCOPE(RoomTiles);
+
+	const bool bInstanced = TileData.Num() > 0;
+	const int32 NumRoomTiles = bInstanced ? TileData.Num() : Tiles.Num();
+
+	//Only needed to turn actor locations into tile coordinates
+	const UTileOccupancySubsystem* Occupancy = GetWorld()->GetSubsystem<UTileOccupancySubsystem>();
+	const FTileOccupancyGrid DefaultGrid;
+	const FTileOccupancyGrid& GridMath = Occupancy ? Occupancy->GetTiles() : DefaultGrid;
+
+	//Tile coordinates of the room, parallel to TileData / Tiles
+	TArray<FIntPoint> Coords;
+	Coords.SetNumUninitialized(NumRoomTiles);
+	TSet<FIntPoint> RoomCoords;
+	RoomCoords.Reserve(NumRoomTiles);
 
-	for (TObjectPtr<AGridSpace> T : Tiles)
+	for (int32 i = 0; i < NumRoomTiles; ++i)
 	{
-		if (!T) continue;
-		//Get an array of empty spaces surrounding the tile
-		const TArray<FVector> EmptyNeighbors = T->GetEmptyNeighbors();
-		//Check to see if the space is an edge space (edges likely to have 2-3 empty neighbors)
-		if (EmptyNeighbors.Num() > 0 && EmptyNeighbors.Num() < 4)
+		if (bInstanced)
 		{
-			//Add to new array of edge pieces
-			EdgeSpaces.Add(T);
-			//Get the Grid Space's mesh
-			if (UStaticMeshComponent* Mesh = T->FindComponentByClass<UStaticMeshComponent>())
-			{
-				//Apply a color to the piece for debug
-				if (EdgeMaterial) Mesh->SetMaterial(0, EdgeMaterial);
-			}
+			Coords[i] = TileData[i].Coord;
+		}
+		else
+		{
+			Coords[i] = Tiles[i] ? GridMath.WorldToTile(Tiles[i]->GetActorLocation()) : FIntPoint(MAX_int32, MAX_int32);
+		}
+		RoomCoords.Add(Coords[i]);
+	}
 
+	EdgeTileIndices.Reset();
+
+	const int32 DX[4] = {1, -1, 0, 0};
+	const int32 DY[4] = {0, 0, 1, -1};
+
+	for (int32 i = 0; i < NumRoomTiles; ++i)
+	{
+		if (!bInstanced && !Tiles[i]) continue;
+
+		//Edge = at least one neighbor that isn't part of this room
+		bool bIsEdge = false;
+		for (int32 d = 0; d < 4 && !bIsEdge; ++d)
+		{
+			bIsEdge = !RoomCoords.Contains(FIntPoint(Coords[i].X + DX[d], Coords[i].Y + DY[d]));
+		}
+
+		if (bInstanced)
+		{
+			TileData[i].SetFlag(ERoomTileFlags::Edge, bIsEdge);
+		}
+		if (!bIsEdge) continue;
+
+		EdgeTileIndices.Add(i);
+
+		if (bInstanced)
+		{
+			//Mark dirty once after the loop
+			TileInstances->SetCustomDataValue(i, 0, 1.f, false);
+		}
+		else if (EdgeMaterial)
+		{
+			//Apply a color to the piece for debug
+			Tiles[i]->GridPlaneMesh->SetMaterial(0, EdgeMaterial);
 		}
 	}
-	if (EdgeSpaces.Num() > 1)
+
+	if (bInstanced && EdgeTileIndices.Num() > 0)
 	{
-		FoundEdges = true;
+		TileInstances->MarkRenderStateDirty();
 	}
-	if (EdgeSpaces.Num() < 1)
+
+	if (EdgeTileIndices.Num() < 1)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("No edges "), *GetName());
-		FoundEdges = false;
+		UE_LOG(LogTemp, Warning, TEXT("No edges in %s"), *GetName());
 	}
-}
\ No newline at end of file
+}
@@ -7,6 +7,34 @@
 #include "DungeonRoom.generated.h"
 
 class AGridSpace;
+class UInstancedStaticMeshComponent;
+struct FDungeonMemoryUsage;
+
+enum class ERoomTileFlags : uint8
+{
+	None = 0,
+	//Tile has at least one free neighbor
+	Edge = 1 << 0,
+};
+ENUM_CLASS_FLAGS(ERoomTileFlags);
+
+//Lightweight tile: coordinates plus flags, rendered through the room's instanced mesh
+USTRUCT()
+struct FRoomTile
+{
+	GENERATED_BODY()
+
+	//Coordinates in the shared tile occupancy grid
+	UPROPERTY()
+	FIntPoint Coord = FIntPoint::ZeroValue;
+
+	//ERoomTileFlags
+	UPROPERTY()
+	uint8 Flags = 0;
+
+	bool HasFlag(ERoomTileFlags Flag) const { return (Flags & (uint8)Flag) != 0; }
+	void SetFlag(ERoomTileFlags Flag, bool bSet) { bSet ? Flags |= (uint8)Flag : Flags &= ~(uint8)Flag; }
+};
 
 UCLASS()
 class PROCEDURALDUNGEON4_API ADungeonRoom : public AActor
@@ -25,6 +53,10 @@ public:
 	UPROPERTY(VisibleAnywhere, Category="Room")
 	TArray<TObjectPtr<AGridSpace>> Tiles;
 
+	//Tiles of a room built in instanced mode, one entry per instance in TileInstances
+	UPROPERTY(VisibleAnywhere, Category="Room")
+	TArray<FRoomTile> TileData;
+
 	UPROPERTY(EditAnywhere, Category = "Room")
 	UMaterialInterface* EdgeMaterial;
 
@@ -34,24 +66,43 @@ public:
 	//Add a tile to this room
 	void AddTile(AGridSpace* Tile);
 
+	//Add a lightweight tile at Coord, call BuildTileInstances once all tiles are in
+	void AddTileCoord(const FIntPoint& Coord);
+
+	//Render every TileData entry as an instance of Mesh, TileOrigin is the world position of tile (0,0)
+	void BuildTileInstances(UStaticMesh* Mesh, const FVector& TileOrigin, float TileSize);
+
+	//Call once after all tiles are added. Finds edge tiles from the room's own tile coordinates
+	void FindEdges();
+
+	//Indices into TileData (instanced rooms) or Tiles (actor rooms) of tiles on the room's border
+	UPROPERTY(VisibleAnywhere, Category="Room")
+	TArray<int32> EdgeTileIndices;
+
 	//Average center of room of tiles
 	FVector GetCenter() const;
 
+	//Tile arrays and instances of this room, for Dungeon.MemReport
+	void GetMemoryUsage(FDungeonMemoryUsage& Out) const;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	//Frees this room's tiles in the world's tile occupancy
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	UPROPERTY()
 	TObjectPtr<USceneComponent> Root;
 
-	void FindEdges();
+	//Renders TileData, custom data slot 0 is 1 for edge tiles
+	UPROPERTY(VisibleAnywhere, Category="Room")
+	TObjectPtr<UInstancedStaticMeshComponent> TileInstances;
 
 private:
 
-	bool FoundEdges = false;
-
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	//Placement used by BuildTileInstances
+	FVector InstanceOrigin = FVector::ZeroVector;
+	float InstanceTileSize = 100.f;
 
 };
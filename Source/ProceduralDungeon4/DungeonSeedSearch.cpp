@@ -0,0 +1,205 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DungeonSeedSearch.h"
+#include "DungeonStats.h"
+#include "DungeonMemory.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	//Breadth first from Start over floor cells, Distances must be all INDEX_NONE on entry.
+	//Returns the cell farthest away and its distance in OutDistance
+	int32 FarthestCell(const FDungeonGrid& Grid, int32 Start, TDungeonScratchArray<int32>& Distances, TDungeonScratchArray<int32>& Queue, int32& OutDistance)
+	{
+		Queue.Reset();
+		Queue.Add(Start);
+		Distances[Start] = 0;
+
+		int32 Farthest = Start;
+		for (int32 Head = 0; Head < Queue.Num(); ++Head)
+		{
+			const int32 Cell = Queue[Head];
+			const int32 X = Cell % Grid.Width;
+			const int32 Y = Cell / Grid.Width;
+
+			if (Distances[Cell] > Distances[Farthest])
+			{
+				Farthest = Cell;
+			}
+
+			const FIntPoint Neighbors[4] = { FIntPoint(X + 1, Y), FIntPoint(X - 1, Y), FIntPoint(X, Y + 1), FIntPoint(X, Y - 1) };
+			for (const FIntPoint& N : Neighbors)
+			{
+				if (!Grid.IsFloor(N.X, N.Y)) continue;
+
+				const int32 NIdx = Grid.Index(N.X, N.Y);
+				if (Distances[NIdx] != INDEX_NONE) continue;
+
+				Distances[NIdx] = Distances[Cell] + 1;
+				Queue.Add(NIdx);
+			}
+		}
+
+		OutDistance = Distances[Farthest];
+		return Farthest;
+	}
+
+	//Seeds meeting every limit first, then by score, then lowest seed so results don't depend on scheduling
+	bool IsBetter(const FDungeonSeedScore& A, const FDungeonSeedScore& B)
+	{
+		if (A.bMeetsConstraints != B.bMeetsConstraints) return A.bMeetsConstraints;
+		if (A.Score != B.Score) return A.Score > B.Score;
+		return A.Seed < B.Seed;
+	}
+}
+
+void DungeonSeedSearch::MeasureLayout(const FDungeonGrid& Grid, FDungeonSeedScore& OutScore)
+{
+	DUNGEON_SCOPE(ScoreLayout);
+
+	OutScore.Seed = Grid.Seed;
+	OutScore.FloorRatio = 0.f;
+	OutScore.RegionCount = 0;
+	OutScore.LongestPath = 0;
+	OutScore.DeadEnds = 0;
+
+	if (!Grid.IsValid()) return;
+
+	FMemMark Mark(FMemStack::Get());
+
+	//Region pass first: label sizes, dead ends and a start cell in the largest region
+	TDungeonScratchArray<int32> Distances;
+	Distances.Init(INDEX_NONE, Grid.Cells.Num());
+
+	TDungeonScratchArray<int32> Queue;
+	Queue.Reserve(Grid.Cells.Num());
+
+	int32 FloorCells = 0;
+	int32 LargestStart = INDEX_NONE;
+	int32 LargestSize = 0;
+
+	for (int32 y = 0; y < Grid.Height; ++y)
+	{
+		for (int32 x = 0; x < Grid.Width; ++x)
+		{
+			if (!Grid.IsFloor(x, y)) continue;
+
+			++FloorCells;
+
+			const int32 FloorNeighbors = Grid.IsFloor(x + 1, y) + Grid.IsFloor(x - 1, y) + Grid.IsFloor(x, y + 1) + Grid.IsFloor(x, y - 1);
+			if (FloorNeighbors == 1)
+			{
+				++OutScore.DeadEnds;
+			}
+
+			const int32 Idx = Grid.Index(x, y);
+			if (Distances[Idx] != INDEX_NONE) continue;
+
+			//Unvisited floor starts a new region, the fill leaves every cell of it marked
+			++OutScore.RegionCount;
+			int32 Unused = 0;
+			FarthestCell(Grid, Idx, Distances, Queue, Unused);
+
+			if (Queue.Num() > LargestSize)
+			{
+				LargestSize = Queue.Num();
+				LargestStart = Idx;
+			}
+		}
+	}
+
+	OutScore.FloorRatio = (float)FloorCells / (float)Grid.Cells.Num();
+	if (LargestStart == INDEX_NONE) return;
+
+	//Double BFS: the farthest cell from anywhere is one end of a longest shortest path, the farthest from that is the other
+	for (int32 Pass = 0; Pass < 2; ++Pass)
+	{
+		for (int32& Distance : Distances)
+		{
+			Distance = INDEX_NONE;
+		}
+		LargestStart = FarthestCell(Grid, LargestStart, Distances, Queue, OutScore.LongestPath);
+	}
+}
+
+void DungeonSeedSearch::ScoreLayout(const FDungeonSeedConstraints& Constraints, int32 Width, int32 Height, FDungeonSeedScore& InOutScore)
+{
+	//How far outside each limit, relative to the limit so the terms are comparable
+	float Miss = 0.f;
+
+	auto MissBelow = [&Miss](float Value, float Min)
+	{
+		if (Min > 0.f && Value < Min) Miss += (Min - Value) / Min;
+	};
+	auto MissAbove = [&Miss](float Value, float Max)
+	{
+		if (Max > 0.f && Value > Max) Miss += (Value - Max) / Max;
+	};
+
+	MissBelow(InOutScore.FloorRatio, Constraints.MinFloorRatio);
+	MissAbove(InOutScore.FloorRatio, Constraints.MaxFloorRatio);
+	MissAbove((float)InOutScore.RegionCount, (float)Constraints.MaxRegions);
+	MissBelow((float)InOutScore.LongestPath, (float)Constraints.MinLongestPath);
+	MissAbove((float)InOutScore.LongestPath, (float)Constraints.MaxLongestPath);
+	MissBelow((float)InOutScore.DeadEnds, (float)Constraints.MinDeadEnds);
+	MissAbove((float)InOutScore.DeadEnds, (float)Constraints.MaxDeadEnds);
+
+	const float FloorCells = FMath::Max(1.f, InOutScore.FloorRatio * Width * Height);
+
+	InOutScore.bMeetsConstraints = Miss <= 0.f;
+	InOutScore.Score = Constraints.FloorRatioWeight * InOutScore.FloorRatio
+		+ Constraints.LongestPathWeight * InOutScore.LongestPath / (float)FMath::Max(1, Width + Height)
+		+ Constraints.DeadEndWeight * InOutScore.DeadEnds * 100.f / FloorCells
+		- Miss;
+}
+
+FDungeonSeedSearchResult DungeonSeedSearch::Search(const TCHAR* Generator, int32 FirstSeed, int32 NumSeeds, int32 NumBest,
+	const FDungeonSeedConstraints& Constraints, TFunctionRef<FDungeonGrid(int32 Seed)> BuildLayout)
+{
+	DUNGEON_LLM_SCOPE(Temp);
+	DUNGEON_SCOPE(SeedSearch);
+
+	FDungeonSeedSearchResult Result;
+
+	//Seeds are never negative, stop before FirstSeed + i overflows
+	FirstSeed = FMath::Max(0, FirstSeed);
+	NumSeeds = FMath::Clamp(NumSeeds, 0, MAX_int32 - FirstSeed);
+	if (NumSeeds == 0 || NumBest <= 0) return Result;
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	//Scores are tiny next to a grid, so keep one per seed and rank once at the end.
+	//Every grid is dropped on the worker that built it
+	TArray<FDungeonSeedScore> Scores;
+	Scores.SetNum(NumSeeds);
+
+	ParallelFor(NumSeeds, [&](int32 i)
+	{
+		const FDungeonGrid Grid = BuildLayout(FirstSeed + i);
+
+		FDungeonSeedScore& Score = Scores[i];
+		MeasureLayout(Grid, Score);
+		Score.Seed = FirstSeed + i;
+		ScoreLayout(Constraints, Grid.Width, Grid.Height, Score);
+	}, EParallelForFlags::Unbalanced);
+
+	for (const FDungeonSeedScore& Score : Scores)
+	{
+		Result.NumMatching += Score.bMeetsConstraints;
+	}
+
+	Scores.Sort([](const FDungeonSeedScore& A, const FDungeonSeedScore& B) { return IsBetter(A, B); });
+	Scores.SetNum(FMath::Min(NumBest, NumSeeds));
+
+	Result.Best = MoveTemp(Scores);
+	Result.NumEvaluated = NumSeeds;
+	Result.Seconds = (float)(FPlatformTime::Seconds() - StartTime);
+	Result.SeedsPerSecond = Result.Seconds > 0.f ? NumSeeds / Result.Seconds : 0.f;
+
+	UE_LOG(LogTemp, Log, TEXT("DungeonSeedSearch: %s evaluated %d seeds from %d in %.2f s (%.0f seeds/s), %d met the constraints, best %d (score %.3f)"),
+		Generator, NumSeeds, FirstSeed, Result.Seconds, Result.SeedsPerSecond, Result.NumMatching,
+		Result.Best[0].Seed, Result.Best[0].Score);
+
+	return Result;
+}
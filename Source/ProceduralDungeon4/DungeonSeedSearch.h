@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DungeonGrid.h"
+#include "DungeonSeedSearch.generated.h"
+
+//What a good layout looks like. Limits set to 0 are ignored
+USTRUCT(BlueprintType)
+struct FDungeonSeedConstraints
+{
+	GENERATED_BODY()
+
+	//Share of all cells that are floor
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Seed Search", meta = (ClampMin = "0", ClampMax = "1"))
+	float MinFloorRatio = 0.3f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Seed Search", meta = (ClampMin = "0", ClampMax = "1"))
+	float MaxFloorRatio = 0.f;
+
+	//4-connected floor regions, 1 = everything reachable
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Seed Search", meta = (ClampMin = "0"))
+	int32 MaxRegions = 1;
+
+	//Walking distance in cells across the largest region
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Seed Search", meta = (ClampMin = "0"))
+	int32 MinLongestPath = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Seed Search", meta = (ClampMin = "0"))
+	int32 MaxLongestPath = 0;
+
+	//Floor cells with exactly one floor neighbor. Few of them reads as linear, many as a maze of stubs
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Seed Search", meta = (ClampMin = "0"))
+	int32 MinDeadEnds = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Seed Search", meta = (ClampMin = "0"))
+	int32 MaxDeadEnds = 0;
+
+	// ---- Ranking ----
+
+	//Among layouts inside the limits, higher score wins. Negative weights prefer less of that metric
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Seed Search")
+	float FloorRatioWeight = 0.f;
+
+	//Applied to the longest path divided by Width + Height
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Seed Search")
+	float LongestPathWeight = 1.f;
+
+	//Applied to dead ends per 100 floor cells
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Seed Search")
+	float DeadEndWeight = 0.f;
+};
+
+//Metrics and score of one seed
+USTRUCT(BlueprintType)
+struct FDungeonSeedScore
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Seed Search")
+	int32 Seed = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Seed Search")
+	float FloorRatio = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Seed Search")
+	int32 RegionCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Seed Search")
+	int32 LongestPath = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Seed Search")
+	int32 DeadEnds = 0;
+
+	//Weighted metrics minus how far the layout misses its limits
+	UPROPERTY(BlueprintReadOnly, Category = "Seed Search")
+	float Score = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Seed Search")
+	bool bMeetsConstraints = false;
+};
+
+USTRUCT(BlueprintType)
+struct FDungeonSeedSearchResult
+{
+	GENERATED_BODY()
+
+	//Best first. Seeds that meet every limit always rank above those that don't
+	UPROPERTY(BlueprintReadOnly, Category = "Seed Search")
+	TArray<FDungeonSeedScore> Best;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Seed Search")
+	int32 NumEvaluated = 0;
+
+	//Seeds that met every limit, including the ones that didn't make it into Best
+	UPROPERTY(BlueprintReadOnly, Category = "Seed Search")
+	int32 NumMatching = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Seed Search")
+	float Seconds = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Seed Search")
+	float SeedsPerSecond = 0.f;
+};
+
+namespace DungeonSeedSearch
+{
+	//Floor ratio, regions, dead ends and the longest path of a finished grid.
+	//The longest path is a double BFS inside the largest region: exact on tree-like layouts, a lower bound otherwise
+	void MeasureLayout(const FDungeonGrid& Grid, FDungeonSeedScore& OutScore);
+
+	//Fill Score and bMeetsConstraints from the metrics MeasureLayout filled in
+	void ScoreLayout(const FDungeonSeedConstraints& Constraints, int32 Width, int32 Height, FDungeonSeedScore& InOutScore);
+
+	//Build, measure and score seeds FirstSeed .. FirstSeed + NumSeeds - 1 on every worker and keep the best NumBest.
+	//BuildLayout runs the logical phase only and is called from many threads at once, so it must only read what it captured
+	FDungeonSeedSearchResult Search(const TCHAR* Generator, int32 FirstSeed, int32 NumSeeds, int32 NumBest,
+		const FDungeonSeedConstraints& Constraints, TFunctionRef<FDungeonGrid(int32 Seed)> BuildLayout);
+
+	//Search for a generator's FindBestSeeds: every layout is a BuilderType over Settings with only the seed replaced.
+	//Build is the builder's logical phase. Split modes and other settings stay as configured, they change which layout a seed gives
+	template <typename BuilderType>
+	FDungeonSeedSearchResult SearchBuilder(const TCHAR* Generator, const decltype(BuilderType::Settings)& Settings, void (BuilderType::*Build)(),
+		int32 FirstSeed, int32 NumSeeds, int32 NumBest, const FDungeonSeedConstraints& Constraints)
+	{
+		return Search(Generator, FirstSeed, NumSeeds, NumBest, Constraints, [&Settings, Build](int32 SearchSeed)
+		{
+			BuilderType Builder(Settings);
+			Builder.Settings.Seed = SearchSeed;
+			(Builder.*Build)();
+			return MoveTemp(Builder.Grid);
+		});
+	}
+}
@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DungeonStats.h"
+
+DEFINE_STAT(STAT_Dungeon_GenerateRoomLayout);
+DEFINE_STAT(STAT_Dungeon_SpawnFloorTiles);
+DEFINE_STAT(STAT_Dungeon_CreateDoors);
+DEFINE_STAT(STAT_Dungeon_RunSimulation);
+DEFINE_STAT(STAT_Dungeon_EnsureConnectivity);
+DEFINE_STAT(STAT_Dungeon_RandomWalk);
+DEFINE_STAT(STAT_Dungeon_SplitSpace);
+DEFINE_STAT(STAT_Dungeon_PlaceRooms);
+DEFINE_STAT(STAT_Dungeon_FillRoomsWithCaves);
+DEFINE_STAT(STAT_Dungeon_ConnectRooms);
+DEFINE_STAT(STAT_Dungeon_GenerateRoom);
+DEFINE_STAT(STAT_Dungeon_SpawnGeometry);
+DEFINE_STAT(STAT_Dungeon_BuildMergedFloor);
+DEFINE_STAT(STAT_Dungeon_LoadChunk);
+DEFINE_STAT(STAT_Dungeon_SeedSearch);
+DEFINE_STAT(STAT_Dungeon_ScoreLayout);
+
+DEFINE_STAT(STAT_Dungeon_CellsProcessed);
+DEFINE_STAT(STAT_Dungeon_RegionsFound);
+DEFINE_STAT(STAT_Dungeon_ActorsSpawned);
+DEFINE_STAT(STAT_Dungeon_CorridorsCarved);
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+//"stat Dungeon" in game, Dungeon_* scopes in Unreal Insights (-trace=cpu)
+DECLARE_STATS_GROUP(TEXT("Dungeon"), STATGROUP_Dungeon, STATCAT_Advanced);
+
+// ---- Phases ----
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GenerateRoomLayout"), STAT_Dungeon_GenerateRoomLayout, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("SpawnFloorTiles"), STAT_Dungeon_SpawnFloorTiles, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CreateDoors"), STAT_Dungeon_CreateDoors, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("RunSimulation"), STAT_Dungeon_RunSimulation, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("EnsureConnectivity"), STAT_Dungeon_EnsureConnectivity, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("RandomWalk"), STAT_Dungeon_RandomWalk, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("SplitSpace"), STAT_Dungeon_SplitSpace, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PlaceRooms"), STAT_Dungeon_PlaceRooms, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("FillRoomsWithCaves"), STAT_Dungeon_FillRoomsWithCaves, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ConnectRooms"), STAT_Dungeon_ConnectRooms, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GenerateRoom"), STAT_Dungeon_GenerateRoom, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("SpawnGeometry"), STAT_Dungeon_SpawnGeometry, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("BuildMergedFloor"), STAT_Dungeon_BuildMergedFloor, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("LoadChunk"), STAT_Dungeon_LoadChunk, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("SeedSearch"), STAT_Dungeon_SeedSearch, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ScoreLayout"), STAT_Dungeon_ScoreLayout, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+
+// ---- Counters ----
+
+//Running totals since startup, not reset per frame, so a one-off generation stays readable
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Cells Processed"), STAT_Dungeon_CellsProcessed, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Regions Found"), STAT_Dungeon_RegionsFound, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Actors Spawned"), STAT_Dungeon_ActorsSpawned, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Corridors Carved"), STAT_Dungeon_CorridorsCarved, STATGROUP_Dungeon, PROCEDURALDUNGEON4_API);
+
+//Stat cycle counter and Insights CPU scope for one phase, Name is the suffix of a STAT_Dungeon_ stat above
+#define DUNGEON_SCOPE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_Dungeon_##Name); \
+	TRACE_CPUPROFILER_EVENT_SCOPE(Dungeon_##Name)
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DungeonTelemetry.h"
+#include "DungeonActorPool.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/DateTime.h"
+
+FDungeonGenerationTelemetry DungeonTelemetry::FromLayout(const TCHAR* Generator, const FDungeonGrid& Grid)
+{
+	FDungeonGenerationTelemetry Telemetry;
+	Telemetry.Generator = Generator;
+	Telemetry.Timestamp = FDateTime::UtcNow().ToIso8601();
+	Telemetry.Seed = Grid.Seed;
+	Telemetry.Width = Grid.Width;
+	Telemetry.Height = Grid.Height;
+
+	Telemetry.FloorCells = Grid.CountFloorCells();
+	Telemetry.WallCells = Grid.Cells.Num() - Telemetry.FloorCells;
+	Telemetry.RegionCount = Grid.CountRegions();
+	Telemetry.CorridorCells = Grid.BuildStats.CorridorCells;
+
+	Telemetry.BuildMs = Grid.BuildStats.BuildMs;
+	Telemetry.PeakTempBytes = Grid.BuildStats.PeakTempBytes;
+	return Telemetry;
+}
+
+FDungeonGenerationTelemetry DungeonTelemetry::FromSpawnPass(const TCHAR* Generator, const FDungeonGrid& Grid, double SpawnStartSeconds, const FDungeonActorPool& Pool)
+{
+	FDungeonGenerationTelemetry Telemetry = FromLayout(Generator, Grid);
+	Telemetry.SpawnMs = (float)((FPlatformTime::Seconds() - SpawnStartSeconds) * 1000.0);
+	Telemetry.ActorsSpawned = Pool.NumSpawned;
+	Telemetry.ActorsReused = Pool.NumReused;
+	return Telemetry;
+}
+
+bool DungeonTelemetry::AppendToCSV(const FDungeonGenerationTelemetry& Telemetry)
+{
+	const FString Path = FPaths::ProjectSavedDir() / TEXT("Telemetry") / TEXT("DungeonGeneration.csv");
+
+	FString Rows;
+	if (!IFileManager::Get().FileExists(*Path))
+	{
+		Rows += TEXT("Timestamp,Generator,Seed,Width,Height,Parameters,FloorCells,WallCells,RegionCount,CorridorCells,")
+			TEXT("BuildMs,SpawnMs,ActorsSpawned,ActorsReused,Instances,MeshChunks,PeakTempBytes\n");
+	}
+
+	//Parameters are space separated, so they never break the columns
+	Rows += FString::Printf(TEXT("%s,%s,%d,%d,%d,%s,%d,%d,%d,%d,%.3f,%.3f,%d,%d,%d,%d,%lld\n"),
+		*Telemetry.Timestamp, *Telemetry.Generator, Telemetry.Seed, Telemetry.Width, Telemetry.Height, *Telemetry.Parameters,
+		Telemetry.FloorCells, Telemetry.WallCells, Telemetry.RegionCount, Telemetry.CorridorCells,
+		Telemetry.BuildMs, Telemetry.SpawnMs, Telemetry.ActorsSpawned, Telemetry.ActorsReused,
+		Telemetry.Instances, Telemetry.MeshChunks, Telemetry.PeakTempBytes);
+
+	const bool bSaved = FFileHelper::SaveStringToFile(Rows, *Path, FFileHelper::EEncodingOptions::AutoDetect,
+		&IFileManager::Get(), FILEWRITE_Append);
+	if (!bSaved)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("DungeonTelemetry: could not append to %s"), *Path);
+	}
+	return bSaved;
+}
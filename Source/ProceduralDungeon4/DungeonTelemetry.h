@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DungeonGrid.h"
+#include "DungeonTelemetry.generated.h"
+
+struct FDungeonActorPool;
+
+//What one generation produced and cost. Every floor generator keeps the last one in LastTelemetry
+USTRUCT(BlueprintType)
+struct FDungeonGenerationTelemetry
+{
+	GENERATED_BODY()
+
+	//Generator class that produced the layout, e.g. "CA"
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	FString Generator;
+
+	//UTC, ISO 8601
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	FString Timestamp;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	int32 Seed = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	int32 Width = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	int32 Height = 0;
+
+	//Generator specific settings as "Name=Value" pairs separated by spaces
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	FString Parameters;
+
+	// ---- Layout ----
+
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	int32 FloorCells = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	int32 WallCells = 0;
+
+	//4-connected floor regions in the finished layout
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	int32 RegionCount = 0;
+
+	//Cells turned into floor by corridor carving
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	int32 CorridorCells = 0;
+
+	// ---- Cost ----
+
+	//Logical generation, on whichever thread ran it
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	float BuildMs = 0.f;
+
+	//Actors, instances and meshes on the game thread
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	float SpawnMs = 0.f;
+
+	//Newly spawned mesh actors
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	int32 ActorsSpawned = 0;
+
+	//Mesh actors taken over from the previous layout
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	int32 ActorsReused = 0;
+
+	//Instanced static mesh instances
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	int32 Instances = 0;
+
+	//Merged floor mesh chunks
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	int32 MeshChunks = 0;
+
+	//Most scratch memory the builder held at once
+	UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+	int64 PeakTempBytes = 0;
+};
+
+namespace DungeonTelemetry
+{
+	//Fresh telemetry with the layout part filled in from a finished grid
+	FDungeonGenerationTelemetry FromLayout(const TCHAR* Generator, const FDungeonGrid& Grid);
+
+	//FromLayout plus the spawn pass that started at SpawnStartSeconds and the actors Pool spawned and reused in it
+	FDungeonGenerationTelemetry FromSpawnPass(const TCHAR* Generator, const FDungeonGrid& Grid, double SpawnStartSeconds, const FDungeonActorPool& Pool);
+
+	//Appends one row to Saved/Telemetry/DungeonGeneration.csv, writing the header if the file is new
+	bool AppendToCSV(const FDungeonGenerationTelemetry& Telemetry);
+}
@@ -6,12 +6,14 @@
 #include "Components/ArrowComponent.h"
 #include "UObject/ConstructorHelpers.h"
 #include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "TileOccupancy.h"
 
 // Sets default values
 AGridSpace::AGridSpace()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
 
 	GridPlaneMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("GridPlaneMeshComponent"));
 	GridPlaneMesh->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
@@ -61,7 +63,7 @@ TArray<FVector> AGridSpace::GetEmptyNeighbors() const
 	TArray<FVector> emptyNeighbors;
 	for (const FVector& pos : NeighborPositions)
 	{
-		if (IsSpaceEmpty(pos, 10.f))
+		if (IsSpaceEmpty(pos))
 		{
 			emptyNeighbors.Add(pos);
 		}
@@ -70,25 +72,12 @@ TArray<FVector> AGridSpace::GetEmptyNeighbors() const
 	return emptyNeighbors;
 }
 
-bool AGridSpace::IsSpaceEmpty(const FVector& Location, float Radius) const
+bool AGridSpace::IsSpaceEmpty(const FVector& Location) const
 {
-	FCollisionShape CollisionShape = FCollisionShape::MakeSphere(Radius);
-
-	//Perform an overlap check
-	TArray<FOverlapResult> Overlaps;
-	FCollisionQueryParams QueryParams;
-	//Ignore self
-	QueryParams.AddIgnoredActor(this);
-
-	bool bHit = GetWorld()->OverlapMultiByChannel(
-		Overlaps,
-		Location,
-		FQuat::Identity,
-		ECC_WorldStatic,
-		CollisionShape,
-		QueryParams
-	);
-
-	//Return true if no overlaps were found
-	return !bHit;
+	const UWorld* World = GetWorld();
+	const UTileOccupancySubsystem* Occupancy = World ? World->GetSubsystem<UTileOccupancySubsystem>() : nullptr;
+	if (!Occupancy) return false;
+
+	const FTileOccupancyGrid& Tiles = Occupancy->GetTiles();
+	return !Tiles.IsOccupied(Tiles.WorldToTile(Location));
 }
\ No newline at end of file
@@ -36,7 +36,8 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta=(AllowPrivateAccess="true"))
 	UArrowComponent* FrontArrow;
 
-	bool IsSpaceEmpty(const FVector& Location, float Radius) const;
+	//Looks Location up in the world's tile occupancy, no physics query
+	bool IsSpaceEmpty(const FVector& Location) const;
 
 	FVector FrontNeighbor;
 	FVector RearNeighbor;
@@ -2,38 +2,35 @@
 
 
 #include "Holmquist_FloorGenerator.h"
+#include "DungeonAsync.h"
+#include "DungeonMeshing.h"
+#include "DungeonStats.h"
+#include "DungeonMemory.h"
 #include "Engine/StaticMeshActor.h"
 #include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
 
 // Sets default values
 AHolmquist_FloorGenerator::AHolmquist_FloorGenerator()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = false;
+	//Fixed seed for reproducibility by default
+	Seed = 12345;
 
-}
-
-// Called when the game starts or when spawned
-void AHolmquist_FloorGenerator::BeginPlay()
-{
-	Super::BeginPlay();
+	Root = CreateDefaultSubobject<USceneComponent>("Root");
+	SetRootComponent(Root);
 
-	//Allocate Grid
-	GenerateRoomLayout();
-	SpawnFloorTiles();
-	CreateDoors(DefaultDoorCount);
-	
 }
 
-// Called every frame
-void AHolmquist_FloorGenerator::Tick(float DeltaTime)
+void FHolmquistLayoutBuilder::GenerateRoomLayout()
 {
-	Super::Tick(DeltaTime);
+	DUNGEON_LLM_SCOPE(Grid);
+	DUNGEON_SCOPE(GenerateRoomLayout);
 
-}
+	const double StartTime = FPlatformTime::Seconds();
+
+	const int32 GridWidth = Settings.GridWidth;
+	const int32 GridHeight = Settings.GridHeight;
 
-void AHolmquist_FloorGenerator::GenerateRoomLayout()
-{
 	//Clear state
 	const int32 NumCells = GridWidth * GridHeight;
 	if (NumCells <= 0)
@@ -42,30 +39,30 @@ void AHolmquist_FloorGenerator::GenerateRoomLayout()
 		return;
 	}
 
-	Grid.Init(false, NumCells);
-	Frontier.Reset();
+	Grid.Init(GridWidth, GridHeight, false);
+	Grid.Seed = Settings.Seed;
+	INC_DWORD_STAT_BY(STAT_Dungeon_CellsProcessed, NumCells);
 
-	//RNG Setup
-	FRandomStream Rng;
-	if (Seed >= 0)
-	{
-		Rng.Initialize(Seed);
-	}
-	else
-	{
-		//Non-deterministic
-		Rng.GenerateNewSeed();
-	}
+	//Frontier is scratch, the grid above is the result
+	DUNGEON_LLM_SCOPE(Temp);
+	FMemMark Mark(FMemStack::Get());
+
+	//List of floor cells to grow from
+	TDungeonScratchArray<FIntPoint> Frontier;
+	Frontier.Reserve(FMath::Clamp(Settings.NumTiles, 1, NumCells));
+
+	//RNG Setup, seed was resolved by the owning actor
+	FRandomStream Rng(Settings.Seed);
 
 	//Choose starting cell at center of grid
 	const int32 StartX = GridWidth / 2;
 	const int32 StartY = GridHeight / 2;
 
-	Grid[Index(StartX, StartY)] = true;
+	Grid.SetFloor(StartX, StartY, true);
 	Frontier.Add(FIntPoint(StartX, StartY));
 
 	int32 TilesPlaced = 1;
-	const int32 TargetTiles = FMath::Clamp(NumTiles, 1, NumCells);
+	const int32 TargetTiles = FMath::Clamp(Settings.NumTiles, 1, NumCells);
 
 	//Grow the room
 	while (TilesPlaced < TargetTiles && Frontier.Num() > 0)
@@ -78,7 +75,8 @@ void AHolmquist_FloorGenerator::GenerateRoomLayout()
 		const int32 Y = Cell.Y;
 
 		//Gather empty neighbors around the cell
-		TArray<FIntPoint> EmptyNeighbors;
+		//At most 4, stays inline on the stack
+		TArray<FIntPoint, TInlineAllocator<4>> EmptyNeighbors;
 
 		const int32 DX[4] = {1, -1, 0, 0};
 		const int32 DY[4] = {0, 0, 1, -1};
@@ -89,9 +87,9 @@ void AHolmquist_FloorGenerator::GenerateRoomLayout()
 			const int32 NY = Y + DY[i];
 
 			//Stay inside the grid
-			if (NX < 0 || NX >= GridWidth || NY < 0 || NY >= GridHeight) continue;
+			if (!Grid.IsInBounds(NX, NY)) continue;
 
-			if (!Grid[Index(NX, NY)])
+			if (!Grid.IsFloor(NX, NY))
 			{
 				EmptyNeighbors.Add(FIntPoint(NX, NY));
 			}
@@ -109,18 +107,120 @@ void AHolmquist_FloorGenerator::GenerateRoomLayout()
 		const FIntPoint NewCell = EmptyNeighbors[RandEmptyIndex];
 
 		//Carve floor
-		Grid[Index(NewCell.X, NewCell.Y)] = true;
+		Grid.SetFloor(NewCell.X, NewCell.Y, true);
 		Frontier.Add(NewCell);
 
 		++TilesPlaced;
 	}
 
-	UE_LOG(LogTemp, Log, TEXT("Holmquist_FloorGenerator: Placed %d floor tiles (target %d)."),
+	UE_LOG(LogTemp, Verbose, TEXT("Holmquist_FloorGenerator: Placed %d floor tiles (target %d)."),
 			TilesPlaced, TargetTiles);
+
+	//Frontier never shrinks its allocation, so its size now is the peak
+	Grid.BuildStats.NoteTempBytes(Frontier.GetAllocatedSize());
+
+	PickDoors();
+
+	Grid.BuildStats.BuildMs = (float)((FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+void FHolmquistLayoutBuilder::PickDoors()
+{
+	DUNGEON_SCOPE(CreateDoors);
+
+	if (Settings.DoorCount <= 0) return;
+
+	FMemMark Mark(FMemStack::Get());
+
+	//Every edge wall, in the order SpawnFloorTiles walks them
+	TDungeonScratchArray<FDungeonDoor> EdgeWalls;
+	for (int32 y = 0; y < Grid.Height; ++y)
+	{
+		for (int32 x = 0; x < Grid.Width; ++x)
+		{
+			if (!Grid.IsFloor(x, y)) continue;
+
+			if (!Grid.IsFloor(x + 1, y)) EdgeWalls.Add({ FIntPoint(x, y), 0 });
+			if (!Grid.IsFloor(x - 1, y)) EdgeWalls.Add({ FIntPoint(x, y), 1 });
+			if (!Grid.IsFloor(x, y + 1)) EdgeWalls.Add({ FIntPoint(x, y), 2 });
+			if (!Grid.IsFloor(x, y - 1)) EdgeWalls.Add({ FIntPoint(x, y), 3 });
+		}
+	}
+
+	if (EdgeWalls.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Holmquist_FloorGenerator: No wall segments to carve doors from!"));
+		return;
+	}
+
+	Grid.BuildStats.NoteTempBytes(EdgeWalls.GetAllocatedSize());
+
+	//Clamp to existing walls
+	const int32 DoorCount = FMath::Min(Settings.DoorCount, EdgeWalls.Num());
+
+	//Reuse Seed so doors are deterministic relative to layout, but offset so it doesn't affect shape generation
+	FRandomStream Rng(Settings.Seed + 1337);
+
+	DUNGEON_LLM_SCOPE(Grid);
+	Grid.Doors.Reserve(DoorCount);
+	for (int32 d = 0; d < DoorCount; ++d)
+	{
+		const int32 Index = Rng.RandRange(0, EdgeWalls.Num() - 1);
+		Grid.Doors.Add(EdgeWalls[Index]);
+		EdgeWalls.RemoveAtSwap(Index);
+	}
+}
+
+FHolmquistLayoutSettings AHolmquist_FloorGenerator::MakeLayoutSettings() const
+{
+	FHolmquistLayoutSettings Settings;
+	Settings.GridWidth = GridWidth;
+	Settings.GridHeight = GridHeight;
+	Settings.NumTiles = NumTiles;
+	Settings.DoorCount = DefaultDoorCount;
+	Settings.Seed = DungeonGrid::ResolveSeed(Seed);
+	return Settings;
+}
+
+void AHolmquist_FloorGenerator::GenerateLayout()
+{
+	FHolmquistLayoutBuilder Builder(MakeLayoutSettings());
+	Builder.GenerateRoomLayout();
+	Layout = MoveTemp(Builder.Grid);
+}
+
+void AHolmquist_FloorGenerator::GenerateLayoutInBackground(TUniqueFunction<void(FDungeonGrid&&)>&& OnBuilt)
+{
+	DungeonAsync::LaunchLayoutTask(this,
+		[Builder = FHolmquistLayoutBuilder(MakeLayoutSettings())]() mutable
+		{
+			Builder.GenerateRoomLayout();
+			return MoveTemp(Builder.Grid);
+		},
+		MoveTemp(OnBuilt));
+}
+
+void AHolmquist_FloorGenerator::SpawnGeometry()
+{
+	DUNGEON_SCOPE(SpawnGeometry);
+	const double SpawnStart = FPlatformTime::Seconds();
+
+	UpdateGenerationDescriptor();
+
+	ActorPool.BeginReuse();
+	WallSegments.Reset();
+
+	SpawnFloorTiles();
+
+	ActorPool.EndReuse();
+
+	RecordTelemetry(SpawnStart);
 }
 
 void AHolmquist_FloorGenerator::SpawnFloorTiles()
 {
+	DUNGEON_SCOPE(SpawnFloorTiles);
+
 	if (!FloorMesh)
 	{
 		UE_LOG(LogTemp, Warning, TEXT("Holmquist_FloorGenerator: FloorMesh not assigned."));
@@ -133,198 +233,92 @@ void AHolmquist_FloorGenerator::SpawnFloorTiles()
 	const float BaseSize = 100.f;
 	const float HalfTile = TileSize * 0.5f;
 
+	if (bMergeFloorMeshes && FloorMesh)
+	{
+		BuildMergedFloor();
+	}
+	else
+	{
+		//Chunks of an earlier merged pass would draw and collide under the per-cell planes
+		DungeonMeshing::DestroyChunks(FloorChunks);
+	}
+
+	//Gathered first and spawned in one batch per mesh at the end
+	TArray<FTransform> FloorTransforms;
+	TArray<FTransform> WallTransforms;
+	TArray<FTransform> PillarTransforms;
+	TArray<FTransform> DoorTransforms;
+
+	//Segments line up with WallTransforms, WallActor gets filled in once the batch is spawned
+	TArray<FHolmquistWallSegment> PendingSegments;
+
+	//Every edge wall has the same size, only position and rotation differ
+	const FVector WallScale(TileSize / BaseSize, WallThickness / BaseSize, WallHeight / BaseSize);
+
+	//Doors take the place and size of the wall they replace
+	auto SpawnEdgeWall = [&](int32 X, int32 Y, uint8 Direction, const FVector& WallPos, const FRotator& Rot)
+	{
+		if (Layout.Doors.Contains(FDungeonDoor{ FIntPoint(X, Y), Direction }))
+		{
+			if (DoorMesh) DoorTransforms.Add(FTransform(Rot, WallPos, WallScale));
+			return;
+		}
+
+		if (!WallMesh) return;
+
+		DUNGEON_LLM_SCOPE(WallSegments);
+		WallTransforms.Add(FTransform(Rot, WallPos, WallScale));
+
+		FHolmquistWallSegment& Seg = PendingSegments.AddDefaulted_GetRef();
+		Seg.Cell = FIntPoint(X, Y);
+		Seg.Direction = Direction;
+	};
+
 	//---- Floors and Edge Walls ----
 
-	for (int32 y = 0; y < GridHeight; ++y)
+	for (int32 y = 0; y < Layout.Height; ++y)
 	{
-		for (int32 x = 0; x < GridWidth; ++x)
+		for (int32 x = 0; x < Layout.Width; ++x)
 		{
-			const bool bIsFloor = Grid[Index(x, y)];
+			const bool bIsFloor = Layout.IsFloor(x, y);
 			const FVector TileCenter = (GetActorLocation() + FVector(x * TileSize, y * TileSize, 0.f));
 
 			//---- Floor ----
-			if (bIsFloor && FloorMesh)
+			if (bIsFloor && FloorMesh && !bMergeFloorMeshes)
 			{
 				const FVector FloorPos = TileCenter + FVector(0.f, 0.f, FloorZ);
-				AStaticMeshActor* FloorActor = World->SpawnActor<AStaticMeshActor>(FloorPos, FRotator::ZeroRotator);
-				if (!FloorActor) continue;
-
-				UStaticMeshComponent* MeshComp = FloorActor->GetStaticMeshComponent();
-				if (!MeshComp)
-				{
-					FloorActor->Destroy();
-					continue;
-				}
-				
-				MeshComp->SetStaticMesh(FloorMesh);
-
 				const float FloorScale = TileSize / BaseSize;
-				FloorActor->SetActorScale3D(FVector(FloorScale, FloorScale, 1.f));
-				FloorActor->SetMobility(EComponentMobility::Static);
+				FloorTransforms.Add(FTransform(FRotator::ZeroRotator, FloorPos, FVector(FloorScale, FloorScale, 1.f)));
 			}
 
-			//---- Walls around Floor ----
-			if (!bIsFloor || !WallMesh)
+			//---- Walls and Doors around Floor ----
+			if (!bIsFloor || (!WallMesh && !DoorMesh))
 			{
 				continue;
 			}
 
-			// Helper lambda to ask "is there floor at (NX, NY)?"
-			auto HasFloorAt = [&](int32 NX, int32 NY) -> bool
-			{
-				if (NX < 0 || NX >= GridWidth || NY < 0 || NY >= GridHeight)
-				{
-					return false;
-				}
-				return Grid[Index(NX, NY)];
-			};
-
 			// EAST (+X) edge  → vertical wall (length along Y)
+			if (!Layout.IsFloor(x + 1, y))
 			{
-				const bool bHasEastFloor = HasFloorAt(x + 1, y);
-				if (!bHasEastFloor)
-				{
-					const FVector WallPos = TileCenter + FVector(HalfTile, 0.f, FloorZ + WallHeight * 0.f);
-					const FRotator Rot(0.f, 90.f, 0.f);
-
-					AStaticMeshActor* WallActor = World->SpawnActor<AStaticMeshActor>(WallPos, Rot);
-					if (WallActor)
-					{
-						UStaticMeshComponent* WComp = WallActor->GetStaticMeshComponent();
-						if (!WComp)
-						{
-							WallActor->Destroy();
-						}
-						else
-						{
-							WComp->SetStaticMesh(WallMesh);
-
-							const float ScaleX = TileSize      / BaseSize; // length
-							const float ScaleY = WallThickness / BaseSize; // thickness
-							const float ScaleZ = WallHeight    / BaseSize; // height
-
-							WallActor->SetActorScale3D(FVector(ScaleX, ScaleY, ScaleZ));
-							WallActor->SetMobility(EComponentMobility::Static);
-
-							FHolmquistWallSegment Seg;
-							Seg.Cell = FIntPoint(x, y);
-							Seg.Direction = 0;
-							Seg.WallActor = WallActor;
-							WallSegments.Add(Seg);
-						}
-					}
-				}
+				SpawnEdgeWall(x, y, 0, TileCenter + FVector(HalfTile, 0.f, FloorZ), FRotator(0.f, 90.f, 0.f));
+			}
 
-				// WEST (-X) edge → vertical wall
-				{
-					const bool bHasWestFloor = HasFloorAt(x - 1, y);
-					if (!bHasWestFloor)
-					{
-						const FVector WallPos = TileCenter + FVector(-HalfTile, 0.f, FloorZ + WallHeight * 0.f);
-						const FRotator Rot(0.f, 90.f, 0.f);
-
-						AStaticMeshActor* WallActor = World->SpawnActor<AStaticMeshActor>(WallPos, Rot);
-						if (WallActor)
-						{
-							UStaticMeshComponent* WComp = WallActor->GetStaticMeshComponent();
-							if (!WComp)
-							{
-								WallActor->Destroy();
-							}
-							else
-							{
-								WComp->SetStaticMesh(WallMesh);
-
-								const float ScaleX = TileSize      / BaseSize;
-								const float ScaleY = WallThickness / BaseSize;
-								const float ScaleZ = WallHeight    / BaseSize;
-
-								WallActor->SetActorScale3D(FVector(ScaleX, ScaleY, ScaleZ));
-								WallActor->SetMobility(EComponentMobility::Static);
-
-							FHolmquistWallSegment Seg;
-							Seg.Cell = FIntPoint(x, y);
-							Seg.Direction = 1;
-							Seg.WallActor = WallActor;
-							WallSegments.Add(Seg);
-							}
-						}
-					}
-				}
+			// WEST (-X) edge → vertical wall
+			if (!Layout.IsFloor(x - 1, y))
+			{
+				SpawnEdgeWall(x, y, 1, TileCenter + FVector(-HalfTile, 0.f, FloorZ), FRotator(0.f, 90.f, 0.f));
+			}
 
-				// NORTH (+Y) edge → horizontal wall (length along X)
-				{
-					const bool bHasNorthFloor = HasFloorAt(x, y + 1);
-					if (!bHasNorthFloor)
-					{
-						const FVector WallPos = TileCenter + FVector(0.f, HalfTile, FloorZ + WallHeight * 0.f);
-						const FRotator Rot(0.f, 0.f, 0.f);
-
-						AStaticMeshActor* WallActor = World->SpawnActor<AStaticMeshActor>(WallPos, Rot);
-						if (WallActor)
-						{
-							UStaticMeshComponent* WComp = WallActor->GetStaticMeshComponent();
-							if (!WComp)
-							{
-								WallActor->Destroy();
-							}
-							else
-							{
-								WComp->SetStaticMesh(WallMesh);
-
-								const float ScaleX = TileSize      / BaseSize;
-								const float ScaleY = WallThickness / BaseSize;
-								const float ScaleZ = WallHeight    / BaseSize;
-
-								WallActor->SetActorScale3D(FVector(ScaleX, ScaleY, ScaleZ));
-								WallActor->SetMobility(EComponentMobility::Static);
-
-							FHolmquistWallSegment Seg;
-							Seg.Cell = FIntPoint(x, y);
-							Seg.Direction = 2;
-							Seg.WallActor = WallActor;
-							WallSegments.Add(Seg);
-							}
-						}
-					}
-				}
+			// NORTH (+Y) edge → horizontal wall (length along X)
+			if (!Layout.IsFloor(x, y + 1))
+			{
+				SpawnEdgeWall(x, y, 2, TileCenter + FVector(0.f, HalfTile, FloorZ), FRotator::ZeroRotator);
+			}
 
-				// SOUTH (-Y) edge → horizontal wall
-				{
-					const bool bHasSouthFloor = HasFloorAt(x, y - 1);
-					if (!bHasSouthFloor)
-					{
-						const FVector WallPos = TileCenter + FVector(0.f, -HalfTile, FloorZ + WallHeight * 0.f);
-						const FRotator Rot(0.f, 0.f, 0.f);
-
-						AStaticMeshActor* WallActor = World->SpawnActor<AStaticMeshActor>(WallPos, Rot);
-						if (WallActor)
-						{
-							UStaticMeshComponent* WComp = WallActor->GetStaticMeshComponent();
-							if (!WComp)
-							{
-								WallActor->Destroy();
-							}
-							else
-							{
-								WComp->SetStaticMesh(WallMesh);
-
-								const float ScaleX = TileSize      / BaseSize;
-								const float ScaleY = WallThickness / BaseSize;
-								const float ScaleZ = WallHeight    / BaseSize;
-
-								WallActor->SetActorScale3D(FVector(ScaleX, ScaleY, ScaleZ));
-								WallActor->SetMobility(EComponentMobility::Static);
-
-							FHolmquistWallSegment Seg;
-							Seg.Cell = FIntPoint(x, y);
-							Seg.Direction = 3;
-							Seg.WallActor = WallActor;
-							WallSegments.Add(Seg);
-							}
-						}
-					}
-				}
+			// SOUTH (-Y) edge → horizontal wall
+			if (!Layout.IsFloor(x, y - 1))
+			{
+				SpawnEdgeWall(x, y, 3, TileCenter + FVector(0.f, -HalfTile, FloorZ), FRotator::ZeroRotator);
 			}
 		}
 	}
@@ -333,11 +327,11 @@ void AHolmquist_FloorGenerator::SpawnFloorTiles()
 
 	if (bSpawnPillarsInGaps && WallMesh)
 	{
-		for (int32 y = 0; y < GridHeight; ++y)
+		for (int32 y = 0; y < Layout.Height; ++y)
 		{
-			for (int32 x = 0; x < GridWidth; ++x)
+			for (int32 x = 0; x < Layout.Width; ++x)
 			{
-				if (Grid[Index(x, y)]) continue;
+				if (Layout.IsFloor(x, y)) continue;
 
 				//Count floor neighbors
 				int32 FloorNeighbors = 0;
@@ -349,9 +343,7 @@ void AHolmquist_FloorGenerator::SpawnFloorTiles()
 					const int32 NX = x + DX[i];
 					const int32 NY = y + DY[i];
 
-					if (NX < 0 || NX >= GridWidth || NY < 0 || NY >= GridHeight) continue;
-
-					if (Grid[Index(NX, NY)]) ++FloorNeighbors;
+					if (Layout.IsFloor(NX, NY)) ++FloorNeighbors;
 				}
 
 				//Only spawn pillars when it's a hole surrounded by floor
@@ -359,93 +351,81 @@ void AHolmquist_FloorGenerator::SpawnFloorTiles()
 
 				const FVector PillarPos = GetActorLocation() + FVector(x * TileSize, y * TileSize, FloorZ);
 
-				AStaticMeshActor* PillarActor = World->SpawnActor<AStaticMeshActor>(PillarPos, FRotator::ZeroRotator);
-				if (!PillarActor) continue;
-
-				UStaticMeshComponent* PComp = PillarActor->GetStaticMeshComponent();
-				if (!PComp)
-				{
-					PillarActor->Destroy();
-					continue;
-				}
-
-				PComp->SetStaticMesh(WallMesh);
-
 				const float XYScale = PillarSize / BaseSize;
 				const float ZScale = WallHeight / BaseSize;
-
-				PillarActor->SetActorScale3D(FVector(XYScale, XYScale, ZScale));
-				PillarActor->SetMobility(EComponentMobility::Static);
+				PillarTransforms.Add(FTransform(FRotator::ZeroRotator, PillarPos, FVector(XYScale, XYScale, ZScale)));
 			}
 		}
 	}
-}
 
-void AHolmquist_FloorGenerator::CreateDoors(int32 DoorCount)
-{
-	if (DoorCount <= 0) return;
+	//---- Spawn ----
+
+	ActorPool.AcquireBatch(World, FloorMesh, FloorTransforms);
+	ActorPool.AcquireBatch(World, WallMesh, PillarTransforms);
+	ActorPool.AcquireBatch(World, DoorMesh, DoorTransforms);
 
-	if (WallSegments.Num() == 0)
+	TArray<AStaticMeshActor*> WallActors;
+	ActorPool.AcquireBatch(World, WallMesh, WallTransforms, &WallActors);
+
+	DUNGEON_LLM_SCOPE(WallSegments);
+	for (int32 i = 0; i < PendingSegments.Num(); ++i)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Holmquist_FloorGenerator: No wall segments to carve doors from!"));
-		return;
+		if (!WallActors[i]) continue;
+
+		PendingSegments[i].WallActor = WallActors[i];
+		WallSegments.Add(PendingSegments[i]);
 	}
+}
 
-	UWorld* World = GetWorld();
-	if (!World) return;
+void AHolmquist_FloorGenerator::BuildMergedFloor()
+{
+	DUNGEON_LLM_SCOPE(Actors);
+	DUNGEON_SCOPE(BuildMergedFloor);
 
-	//Clamp to existing walls
-	DoorCount = FMath::Min(DoorCount, WallSegments.Num());
+	//Cells are centered on their coordinates, so cell (0,0) starts half a tile back
+	const FVector CellOrigin(-TileSize * 0.5f, -TileSize * 0.5f, FloorZ);
 
-	//Reuse Seed so doors are deterministic relative to layout, but offset so it doesn't affect shape generation
-	FRandomStream Rng;
-	if (Seed >= 0)
-	{
-		Rng.Initialize(Seed + 1337);
-	}
-	else
-	{
-		Rng.GenerateNewSeed();
-	}
+	DungeonMeshing::BuildFloorChunks(this, Root, Layout, FloorChunkSize, TileSize, CellOrigin,
+		FloorMesh ? FloorMesh->GetMaterial(0) : nullptr, FloorChunks);
+}
 
-	for (int32 d = 0; d < DoorCount && WallSegments.Num() > 0; ++d)
-	{
-		const int32 Index = Rng.RandRange(0, WallSegments.Num() - 1);
-		FHolmquistWallSegment Seg = WallSegments[Index];
+bool AHolmquist_FloorGenerator::PrepareBake()
+{
+	//Merged chunks are procedural meshes, which can't hold lightmaps. Bake per-cell floor actors instead
+	bMergeFloorMeshes = false;
+	return true;
+}
 
-		AStaticMeshActor* WallActor = Seg.WallActor.Get();
-		if (!WallActor)
-		{
-			//Dead pointer, discard and retry
-			WallSegments.RemoveAtSwap(Index);
-			--d;
-			continue;
-		}
+FDungeonSeedSearchResult AHolmquist_FloorGenerator::SearchSeeds(const FDungeonSeedConstraints& Constraints, int32 NumSeeds, int32 NumBest, int32 FirstSeed) const
+{
+	return DungeonSeedSearch::SearchBuilder(GetGeneratorName(), MakeLayoutSettings(), &FHolmquistLayoutBuilder::GenerateRoomLayout, FirstSeed, NumSeeds, NumBest, Constraints);
+}
 
-		const FTransform WallTransform = WallActor->GetActorTransform();
+void AHolmquist_FloorGenerator::UpdateGenerationDescriptor()
+{
+	DungeonReplication::UpdateDescriptor(this, bReplicateGeneration, GetGeneratorName(), MakeLayoutSettings(), Layout, GenerationDescriptor);
+}
 
-		//Remove the wall section
-		WallActor->Destroy();
-		WallSegments.RemoveAtSwap(Index);
+void AHolmquist_FloorGenerator::ApplyGenerationDescriptor()
+{
+	FHolmquistLayoutSettings Settings;
+	if (!DungeonReplication::ReadSettings(GenerationDescriptor, GetGeneratorName(), Settings)) return;
 
-		//Spawn a door mesh
-		if (DoorMesh)
+	DungeonReplication::BuildFromDescriptor(this, GenerationDescriptor, Settings, &FHolmquistLayoutBuilder::GenerateRoomLayout, bGenerateAsync, OnLayoutReady,
+		[this](FHolmquistLayoutBuilder& Builder)
 		{
-			AStaticMeshActor* DoorActor = World->SpawnActor<AStaticMeshActor>(WallTransform.GetLocation(), WallTransform.GetRotation().Rotator());
+			SpawnLayout(Builder.Grid);
+		});
+}
 
-			if (DoorActor)
-			{
-				if (UStaticMeshComponent* DoorComp = DoorActor->GetStaticMeshComponent())
-				{
-					DoorComp->SetStaticMesh(DoorMesh);
-					DoorActor->SetActorScale3D(WallTransform.GetScale3D());
-					DoorActor->SetMobility(EComponentMobility::Static);
-				}
-				else
-				{
-					DoorActor->Destroy();
-				}
-			}
-		}
-	}
-}
\ No newline at end of file
+void AHolmquist_FloorGenerator::AddTelemetryDetails(FDungeonGenerationTelemetry& Telemetry) const
+{
+	Telemetry.Parameters = FString::Printf(TEXT("NumTiles=%d DoorCount=%d Pillars=%d"), NumTiles, DefaultDoorCount, bSpawnPillarsInGaps ? 1 : 0);
+	Telemetry.MeshChunks = FloorChunks.Num();
+}
+
+void AHolmquist_FloorGenerator::GetMemoryUsage(FDungeonMemoryUsage& Out) const
+{
+	Super::GetMemoryUsage(Out);
+	Out.WallSegmentBytes += WallSegments.GetAllocatedSize();
+}
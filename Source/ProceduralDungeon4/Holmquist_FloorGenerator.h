@@ -3,10 +3,11 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
+#include "DungeonFloorGeneratorBase.h"
 #include "Holmquist_FloorGenerator.generated.h"
 
 class AStaticMeshActor;
+class UProceduralMeshComponent;
 
 USTRUCT()
 struct FHolmquistWallSegment
@@ -26,8 +27,52 @@ struct FHolmquistWallSegment
 	TWeakObjectPtr<AStaticMeshActor> WallActor;
 };
 
+//Parameters of the logical phase, copied out of the actor before generation
+USTRUCT(BlueprintType)
+struct FHolmquistLayoutSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Room Gen")
+	int32 GridWidth = 20;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Room Gen")
+	int32 GridHeight = 20;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Room Gen")
+	int32 NumTiles = 50;
+
+	//Edge walls turned into doors, clamped to the number of edge walls
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Room Gen")
+	int32 DoorCount = 3;
+
+	//Already resolved, never negative
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Room Gen")
+	int32 Seed = 12345;
+};
+
+//Logical phase of AHolmquist_FloorGenerator. Touches no UObjects, so it is safe to run on a worker thread
+struct FHolmquistLayoutBuilder
+{
+	explicit FHolmquistLayoutBuilder(const FHolmquistLayoutSettings& InSettings)
+		: Settings(InSettings)
+	{}
+
+	//Fills Grid, doors included
+	void GenerateRoomLayout();
+
+	FHolmquistLayoutSettings Settings;
+
+	//Logical grid - true = floor, false = empty
+	FDungeonGrid Grid;
+
+private:
+	//Pick Grid.Doors among the edge walls of the finished grid
+	void PickDoors();
+};
+
 UCLASS()
-class PROCEDURALDUNGEON4_API AHolmquist_FloorGenerator : public AActor
+class PROCEDURALDUNGEON4_API AHolmquist_FloorGenerator : public ADungeonFloorGeneratorBase
 {
 	GENERATED_BODY()
 	
@@ -35,10 +80,9 @@ public:
 	// Sets default values for this actor's properties
 	AHolmquist_FloorGenerator();
 
-protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
+	virtual void GetMemoryUsage(FDungeonMemoryUsage& Out) const override;
 
+protected:
 	// ---- Config ----
 
 	// -- Floor --
@@ -57,19 +101,11 @@ protected:
 	//Size of each tile in world units
 	UPROPERTY(EditAnywhere, Category = "Room Gen")
 	float TileSize = 400.f;
-
-	//Random seed for reproducibility
-	UPROPERTY(EditAnywhere, Category = "Room Gen")
-	int32 Seed = 12345;
 	
 	//Vertical offset for the floor tiles
 	UPROPERTY(EditAnywhere, Category = "Room Gen")
 	float FloorZ = 0.f;
 
-	//Mesh for the floor
-	UPROPERTY(EditAnywhere, Category = "Room Gen")
-	UStaticMesh* FloorMesh;
-
 	// -- Walls --
 
 	//Height of the walls in world units
@@ -88,10 +124,6 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Walls")
 	float PillarSize = 40.f;
 
-	//Mesh for the Walls
-	UPROPERTY(EditAnywhere, Category = "Walls")
-	UStaticMesh* WallMesh;
-
 	// -- Doors --
 	
 	//How many doors to carve out
@@ -102,36 +134,57 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Doors")
 	UStaticMesh* DoorMesh = nullptr;
 
-	//---- Internal Data ----
+	// ---- Floor Meshing ----
 
-	//Logical grid - true = floor, false = empty
-	TArray<bool> Grid;
+	//Merge floor cells into rectangles per chunk and draw each chunk as one procedural mesh
+	//instead of one plane actor per cell. Uses FloorMesh's material
+	UPROPERTY(EditAnywhere, Category = "Floor Meshing")
+	bool bMergeFloorMeshes = true;
 
-	//List of floor cells to grow from
-	TArray<FIntPoint> Frontier;
+	//Chunk size in cells
+	UPROPERTY(EditAnywhere, Category = "Floor Meshing", meta = (EditCondition = "bMergeFloorMeshes", ClampMin = "1"))
+	int32 FloorChunkSize = 32;
+
+	UPROPERTY(VisibleAnywhere, Category = "Components")
+	TObjectPtr<USceneComponent> Root;
+
+	//One merged floor mesh per chunk
+	UPROPERTY()
+	TArray<TObjectPtr<UProceduralMeshComponent>> FloorChunks;
+
+	//bMergeFloorMeshes path, replaces the per-cell floor planes
+	void BuildMergedFloor();
+
+	//---- Internal Data ----
 
 	//All spawned Wall segments
 	UPROPERTY()
 	TArray<FHolmquistWallSegment> WallSegments;
 
-	FORCEINLINE int32 Index(int32 X, int32 Y) const
-	{
-		return Y * GridWidth + X;
-	}
-
 	//---- Pipeline ----
 
-	//Fills the Grid[]
-	void GenerateRoomLayout();
-
-	//Spawns floor meshes from the Grid[]
+	//Spawns floor meshes from Layout, and a door instead of the wall on every edge in Layout.Doors
 	void SpawnFloorTiles();
 
-	//Spawn the doors
-	void CreateDoors(int32 DoorCount);
+	// ---- Builder hooks ----
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	virtual const TCHAR* GetGeneratorName() const override { return TEXT("Holmquist"); }
+	virtual void GenerateLayout() override;
+	virtual void GenerateLayoutInBackground(TUniqueFunction<void(FDungeonGrid&&)>&& OnBuilt) override;
+	virtual void UpdateGenerationDescriptor() override;
+	virtual void ApplyGenerationDescriptor() override;
+	virtual FDungeonSeedSearchResult SearchSeeds(const FDungeonSeedConstraints& Constraints, int32 NumSeeds, int32 NumBest, int32 FirstSeed) const override;
+
+	//Floors, walls and doors for Layout in one pooled pass
+	virtual void SpawnGeometry() override;
+
+	virtual void AddTelemetryDetails(FDungeonGenerationTelemetry& Telemetry) const override;
+
+	//Merged floors are baked as per-cell actors
+	virtual bool PrepareBake() override;
+
+private:
+	//Snapshot of the config above with the seed resolved
+	FHolmquistLayoutSettings MakeLayoutSettings() const;
 
 };
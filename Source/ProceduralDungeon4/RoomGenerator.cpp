@@ -7,6 +7,36 @@
 #include "Engine/World.h"
 #include "ProceduralDungeonGameMode.h"
 #include "DungeonRoom.h"
+#include "TileOccupancy.h"
+#include "DungeonGrid.h"
+#include "DungeonStats.h"
+#include "DungeonMemory.h"
+#include "UObject/ConstructorHelpers.h"
+#include "Engine/StaticMesh.h"
+
+namespace
+{
+	//Start itself if it's free, otherwise the first free tile on the closest ring of Manhattan distance around it.
+	//The occupied set is finite, so some ring always has a free tile
+	FIntPoint FindNearestFreeTile(const FTileOccupancyGrid& Occupied, const FIntPoint& Start)
+	{
+		if (!Occupied.IsOccupied(Start)) return Start;
+
+		for (int32 Distance = 1; ; ++Distance)
+		{
+			for (int32 dx = -Distance; dx <= Distance; ++dx)
+			{
+				const int32 dy = Distance - FMath::Abs(dx);
+
+				const FIntPoint Below(Start.X + dx, Start.Y - dy);
+				if (!Occupied.IsOccupied(Below)) return Below;
+
+				const FIntPoint Above(Start.X + dx, Start.Y + dy);
+				if (!Occupied.IsOccupied(Above)) return Above;
+			}
+		}
+	}
+}
 
 // Sets default values
 ARoomGenerator::ARoomGenerator()
@@ -15,7 +45,15 @@ ARoomGenerator::ARoomGenerator()
 	PrimaryActorTick.bCanEverTick = true;
 
 	SpawnParams.Owner = this;
-    SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	//Free space is tracked by the tile occupancy grid, so skip the spawn-time encroachment check
+    SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	//Same plane AGridSpace uses
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> PlaneAsset(TEXT("/Engine/BasicShapes/Plane"));
+	if (PlaneAsset.Succeeded())
+	{
+		TileMesh = PlaneAsset.Object;
+	}
 
 }
 
@@ -24,7 +62,7 @@ void ARoomGenerator::BeginPlay()
 {
 	Super::BeginPlay();
 
-	if (!GridTileToSpawn)
+	if (!GridTileToSpawn && !bUseInstancedTiles)
     {
         UE_LOG(LogTemp, Warning, TEXT("GridTileToSpawn not assigned in %s"), *GetName());
         return;
@@ -56,6 +94,11 @@ void ARoomGenerator::BeginPlay()
 				{
 					TargetLocation = GridSpacesInRoom[0]->GetActorLocation() + FVector(0.f, 0.f, 100.f);
 				}
+				else if (DungeonRoom1 && DungeonRoom1->TileData.Num() > 0)
+				{
+					const FTileOccupancyGrid& Tiles = GetWorld()->GetSubsystem<UTileOccupancySubsystem>()->GetTiles();
+					TargetLocation = Tiles.TileToWorld(DungeonRoom1->TileData[0].Coord, SpawnLocation.Z) + FVector(0.f, 0.f, 100.f);
+				}
 
 				// Move and rotate player
 				PlayerPawn->SetActorLocation(TargetLocation);
@@ -86,6 +129,8 @@ void ARoomGenerator::Tick(float DeltaTime)
 
 void ARoomGenerator::SpawnTile(const FVector& spawnLocation)
 {
+	DUNGEON_LLM_SCOPE(Actors);
+
 	AGridSpace* GridTile = GetWorld()->SpawnActor<AGridSpace>(
 		GridTileToSpawn,
 		spawnLocation,
@@ -97,14 +142,28 @@ void ARoomGenerator::SpawnTile(const FVector& spawnLocation)
 	{
 		tilesSpawned++;
 		GridSpacesInRoom.Add(GridTile);
+		INC_DWORD_STAT(STAT_Dungeon_ActorsSpawned);
+
+		//Mark the tile as taken so neighbor checks see it immediately
+		if (UTileOccupancySubsystem* Occupancy = GetWorld()->GetSubsystem<UTileOccupancySubsystem>())
+		{
+			FTileOccupancyGrid& Tiles = Occupancy->GetTiles();
+			Tiles.Add(Tiles.WorldToTile(spawnLocation));
+		}
 	}
 }
 
 ADungeonRoom* ARoomGenerator::GenerateRoom(int32 TilesToCreate)
 {
+	DUNGEON_SCOPE(GenerateRoom);
 
 	UWorld* World = GetWorld();
-    if (!World || !DungeonRoomClass || !GridTileToSpawn) return nullptr;
+    if (!World || !DungeonRoomClass) return nullptr;
+	if (!bUseInstancedTiles && !GridTileToSpawn) return nullptr;
+
+	UTileOccupancySubsystem* Occupancy = World->GetSubsystem<UTileOccupancySubsystem>();
+	if (!Occupancy) return nullptr;
+	FTileOccupancyGrid& Occupied = Occupancy->GetTiles();
 
 	//Make the room actor
     ADungeonRoom* Room = World->SpawnActor<ADungeonRoom>(DungeonRoomClass, FTransform::Identity);
@@ -115,36 +174,31 @@ ADungeonRoom* ARoomGenerator::GenerateRoom(int32 TilesToCreate)
 	tilesSpawned = 0;
 	GridSpacesInRoom.Empty();
 
-	//Spawn tiles based on numTiles
-	for(int32 i=TilesToCreate; i > 0; --i)
+	//Grow the room in tile coordinates, SpawnLocation snaps to the shared tile grid
+	const FIntPoint StartCoord = Occupied.WorldToTile(SpawnLocation);
+	FRandomStream Rng(DungeonGrid::ResolveSeed(Seed));
+
+	TArray<FIntPoint> RoomCoords;
+	GrowRoomLayout(TilesToCreate, StartCoord, Rng, Occupied, RoomCoords);
+	INC_DWORD_STAT_BY(STAT_Dungeon_CellsProcessed, RoomCoords.Num());
+
+	if (bUseInstancedTiles)
 	{
-		//Check to see if any tiles have been spawned yet
-		if (tilesSpawned == 0)
+		//Plain structs in the room, one instance per tile
+		for (const FIntPoint& Coord : RoomCoords)
 		{
-			//Spawn a default Tile at 0,0,0
-			SpawnTile(SpawnLocation);
-
+			Room->AddTileCoord(Coord);
 		}
-		if (GridSpacesInRoom.Num() > 0)
-		{
-			//Choose a random tile from the GridSpacesInRoom array
-			const int32 RandomTileIndex = FMath::RandRange(0, GridSpacesInRoom.Num() - 1);
-			AGridSpace* RandomTile = GridSpacesInRoom[RandomTileIndex];
-
-			//Get an array of empty spaces surrounding the tile
-			const TArray<FVector> EmptyNeighbors = RandomTile->GetEmptyNeighbors();
-
-			if (EmptyNeighbors.Num() > 0)
-			{
-				//Choose a random space in the EmptyNeighbors array
-				const int32 RandomEmptyNeighborIndex = FMath::RandRange(0, EmptyNeighbors.Num() - 1);
-				FVector RandomEmptyNeighbor = EmptyNeighbors[RandomEmptyNeighborIndex];
+		Room->BuildTileInstances(TileMesh, FVector(0.f, 0.f, SpawnLocation.Z), Occupied.TileSize);
+		Room->FindEdges();
+		tilesSpawned = RoomCoords.Num();
+		return Room;
+	}
 
-				//Spawn a tile at the random space's location
-				SpawnTile(RandomEmptyNeighbor);
-			}
-			
-		}
+	//Spawn a tile actor at every claimed space
+	for (const FIntPoint& Coord : RoomCoords)
+	{
+		SpawnTile(Occupied.TileToWorld(Coord, SpawnLocation.Z));
 	}
 
 	//Attach every spawned tile to the room and register it
@@ -153,7 +207,63 @@ ADungeonRoom* ARoomGenerator::GenerateRoom(int32 TilesToCreate)
 		if (!Tile) continue;
 		Room->AddTile(Tile);
 	}
+	Room->FindEdges();
 
 	return Room;
 }
 
+void ARoomGenerator::GrowRoomLayout(int32 TilesToCreate, const FIntPoint& Start, FRandomStream& Rng, FTileOccupancyGrid& Occupied, TArray<FIntPoint>& OutCoords)
+{
+	OutCoords.Reset();
+	if (TilesToCreate <= 0) return;
+
+	OutCoords.Reserve(TilesToCreate);
+
+	//Another room may already own Start (e.g. two generators on the same spot), grow from the nearest free tile instead
+	const FIntPoint Origin = FindNearestFreeTile(Occupied, Start);
+
+	//Place a default Tile at the start location
+	Occupied.Add(Origin);
+	OutCoords.Add(Origin);
+
+	//Tiles that may still have free neighbors. Every iteration either places a tile or drops a
+	//frontier entry for good, so growth finishes in O(TilesToCreate)
+	FMemMark Mark(FMemStack::Get());
+	TDungeonScratchArray<FIntPoint> Frontier;
+	Frontier.Reserve(TilesToCreate);
+	Frontier.Add(Origin);
+
+	TArray<FIntPoint> EmptyNeighbors;
+
+	//Runs dry only if Origin sits in a pocket enclosed by other rooms, the room then comes out smaller than TilesToCreate
+	while (OutCoords.Num() < TilesToCreate && Frontier.Num() > 0)
+	{
+		//Choose a random tile to grow from
+		const int32 FrontierIndex = Rng.RandRange(0, Frontier.Num() - 1);
+		const FIntPoint Cell = Frontier[FrontierIndex];
+
+		EmptyNeighbors.Reset();
+		Occupied.GetEmptyNeighbors(Cell, EmptyNeighbors);
+
+		if (EmptyNeighbors.Num() == 0)
+		{
+			//Fully surrounded, never pick it again
+			Frontier.RemoveAtSwap(FrontierIndex);
+			continue;
+		}
+
+		//Choose a random empty neighbor and claim it
+		const int32 RandomEmptyNeighborIndex = Rng.RandRange(0, EmptyNeighbors.Num() - 1);
+		const FIntPoint NewCell = EmptyNeighbors[RandomEmptyNeighborIndex];
+
+		Occupied.Add(NewCell);
+		OutCoords.Add(NewCell);
+		Frontier.Add(NewCell);
+
+		//That was the last free neighbor of Cell
+		if (EmptyNeighbors.Num() == 1)
+		{
+			Frontier.RemoveAtSwap(FrontierIndex);
+		}
+	}
+}
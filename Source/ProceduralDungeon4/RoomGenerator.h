@@ -8,11 +8,15 @@
 
 class AGridSpace;
 class ADungeonRoom;
+struct FTileOccupancyGrid;
 
 UCLASS()
 class PROCEDURALDUNGEON4_API ARoomGenerator : public AActor
 {
 	GENERATED_BODY()
+
+	//Drives generation and spawning directly for timing runs
+	friend class UDungeonBenchmarkCommandlet;
 	
 public:	
 	// Sets default values for this actor's properties
@@ -21,6 +25,14 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Room Generation")
 	int numTiles = 1;
 
+	//Random seed for room growth, -1 = new seed every run
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Room Generation")
+	int32 Seed = -1;
+
+	//Grow a room of TilesToCreate tiles from Start, or from the nearest free tile if Start is taken, claiming each tile in Occupied.
+	//Comes out short only when boxed in by other rooms. Only touches its arguments, so it can run on any thread with its own occupancy grid
+	static void GrowRoomLayout(int32 TilesToCreate, const FIntPoint& Start, FRandomStream& Rng, FTileOccupancyGrid& Occupied, TArray<FIntPoint>& OutCoords);
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
@@ -42,6 +54,15 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Spawning")
 	TSubclassOf<ADungeonRoom> DungeonRoomClass;
 
+	//Store tiles as plain coordinates in the room and draw them with one instanced mesh
+	//instead of spawning an AGridSpace actor per tile
+	UPROPERTY(EditAnywhere, Category="Spawning")
+	bool bUseInstancedTiles = false;
+
+	//Mesh for instanced tiles
+	UPROPERTY(EditAnywhere, Category="Spawning", meta=(EditCondition="bUseInstancedTiles"))
+	UStaticMesh* TileMesh;
+
 	ADungeonRoom* GenerateRoom(int32 TilesToCreate);
 
 	void SpawnTile(const FVector& spawnLocation);
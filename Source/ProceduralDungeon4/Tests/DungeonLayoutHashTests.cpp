@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "CA_FloorGenerator.h"
+#include "Walk_FloorGenerator.h"
+#include "Holmquist_FloorGenerator.h"
+#include "BSP_FloorGenerator.h"
+#include "RoomGenerator.h"
+#include "TileOccupancy.h"
+#include "Hash/xxhash.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	//Goldens/DungeonLayoutHashes.csv, recorded by -run=DungeonBenchmark -NoSpawn -UpdateGoldens.
+	//Generator,Width,Height,Seed,LayoutHash - keyed by everything before the last comma
+	TMap<FString, FString> LoadLayoutHashGoldens()
+	{
+		TMap<FString, FString> Goldens;
+
+		TArray<FString> Lines;
+		FFileHelper::LoadFileToStringArray(Lines, *(FPaths::ProjectDir() / TEXT("Goldens") / TEXT("DungeonLayoutHashes.csv")));
+		for (int32 i = 1; i < Lines.Num(); ++i)
+		{
+			int32 Split = INDEX_NONE;
+			if (!Lines[i].FindLastChar(TEXT(','), Split)) continue;
+
+			Goldens.Add(Lines[i].Left(Split), Lines[i].Mid(Split + 1).TrimStartAndEnd());
+		}
+		return Goldens;
+	}
+
+	//Logical phase only, the way the benchmark maps Size onto each generator's settings
+	uint64 BuildLayoutHash(const FString& Generator, int32 Size, int32 Seed)
+	{
+		if (Generator == TEXT("CA"))
+		{
+			FCALayoutSettings Settings;
+			Settings.MapWidth = Size;
+			Settings.MapHeight = Size;
+			Settings.Seed = Seed;
+
+			FCALayoutBuilder Builder(Settings);
+			Builder.Build();
+			return Builder.Grid.ComputeLayoutHash();
+		}
+
+		if (Generator == TEXT("Walk"))
+		{
+			FWalkLayoutSettings Settings;
+			Settings.MapWidth = Size;
+			Settings.MapHeight = Size;
+			Settings.NumSteps = Size * Size / 2;
+			Settings.Seed = Seed;
+
+			FWalkLayoutBuilder Builder(Settings);
+			Builder.GenerateMap();
+			return Builder.Grid.ComputeLayoutHash();
+		}
+
+		if (Generator == TEXT("Holmquist"))
+		{
+			FHolmquistLayoutSettings Settings;
+			Settings.GridWidth = Size;
+			Settings.GridHeight = Size;
+			Settings.NumTiles = Size * Size / 2;
+			Settings.Seed = Seed;
+
+			FHolmquistLayoutBuilder Builder(Settings);
+			Builder.GenerateRoomLayout();
+			return Builder.Grid.ComputeLayoutHash();
+		}
+
+		if (Generator == TEXT("BSP"))
+		{
+			FBSPLayoutSettings Settings;
+			Settings.MapSize = FIntPoint(Size, Size);
+			Settings.Seed = Seed;
+
+			FBSPLayoutBuilder Builder(Settings);
+			Builder.GenerateBSP();
+			return Builder.Grid.ComputeLayoutHash();
+		}
+
+		//Room: no grid, the tile coordinates in growth order are the whole logical output
+		FTileOccupancyGrid Occupied;
+		FRandomStream Rng(Seed);
+		TArray<FIntPoint> Coords;
+		ARoomGenerator::GrowRoomLayout(Size * Size / 2, FIntPoint::ZeroValue, Rng, Occupied, Coords);
+		return FXxHash64::HashBuffer(Coords.GetData(), Coords.Num() * sizeof(FIntPoint)).Hash;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDungeonLayoutHashGoldensTest, "ProceduralDungeon.LayoutHash.Goldens",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FDungeonLayoutHashGoldensTest::RunTest(const FString& Parameters)
+{
+	//A mismatch prints the new hash. Re-record the goldens only for an intended layout change
+	const TMap<FString, FString> Goldens = LoadLayoutHashGoldens();
+
+	const TCHAR* Generators[] = { TEXT("CA"), TEXT("Walk"), TEXT("Holmquist"), TEXT("BSP"), TEXT("Room") };
+	const int32 Sizes[] = { 32, 64 };
+
+	int32 NumMissing = 0;
+	for (const TCHAR* Generator : Generators)
+	{
+		for (const int32 Size : Sizes)
+		{
+			for (int32 Seed = 0; Seed < 3; ++Seed)
+			{
+				const FString* Golden = Goldens.Find(FString::Printf(TEXT("%s,%d,%d,%d"), Generator, Size, Size, Seed));
+				if (!Golden)
+				{
+					++NumMissing;
+					continue;
+				}
+
+				const uint64 Hash = BuildLayoutHash(Generator, Size, Seed);
+				TestEqual(FString::Printf(TEXT("%s %dx%d seed %d"), Generator, Size, Size, Seed), DungeonGrid::LayoutHashToString(Hash), *Golden);
+			}
+		}
+	}
+
+	//Nothing to compare against until the goldens are recorded, that alone is no failure
+	if (NumMissing > 0)
+	{
+		AddWarning(FString::Printf(TEXT("%d layouts have no golden, record them with -run=DungeonBenchmark -NoSpawn -UpdateGoldens"), NumMissing));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDungeonLayoutHashParallelBSPTest, "ProceduralDungeon.LayoutHash.ParallelBSP",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FDungeonLayoutHashParallelBSPTest::RunTest(const FString& Parameters)
+{
+	//Parallel split and cave rooms run on the task graph, the layout must not depend on scheduling
+	FBSPLayoutSettings Settings;
+	Settings.MapSize = FIntPoint(128, 128);
+	Settings.MaxDepth = 8;
+	Settings.bParallelSplit = true;
+	Settings.bCaveRooms = true;
+
+	for (int32 Seed = 0; Seed < 3; ++Seed)
+	{
+		Settings.Seed = Seed;
+
+		FBSPLayoutBuilder First(Settings);
+		First.GenerateBSP();
+
+		FBSPLayoutBuilder Second(Settings);
+		Second.GenerateBSP();
+
+		TestEqual(FString::Printf(TEXT("Parallel BSP seed %d"), Seed),
+			DungeonGrid::LayoutHashToString(Second.Grid.ComputeLayoutHash()), DungeonGrid::LayoutHashToString(First.Grid.ComputeLayoutHash()));
+	}
+	return true;
+}
+
+#endif
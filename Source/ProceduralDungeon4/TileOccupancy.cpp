@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TileOccupancy.h"
+
+FIntPoint FTileOccupancyGrid::WorldToTile(const FVector& Location) const
+{
+	return FIntPoint(
+		FMath::RoundToInt(Location.X / TileSize),
+		FMath::RoundToInt(Location.Y / TileSize)
+	);
+}
+
+FVector FTileOccupancyGrid::TileToWorld(const FIntPoint& Tile, float Z) const
+{
+	return FVector(Tile.X * TileSize, Tile.Y * TileSize, Z);
+}
+
+bool FTileOccupancyGrid::Add(const FIntPoint& Tile)
+{
+	bool bAlreadyOccupied = false;
+	Occupied.Add(Tile, &bAlreadyOccupied);
+	return !bAlreadyOccupied;
+}
+
+void FTileOccupancyGrid::Remove(const FIntPoint& Tile)
+{
+	Occupied.Remove(Tile);
+}
+
+void FTileOccupancyGrid::Reset()
+{
+	Occupied.Reset();
+}
+
+void FTileOccupancyGrid::GetEmptyNeighbors(const FIntPoint& Tile, TArray<FIntPoint>& OutNeighbors) const
+{
+	const int32 DX[4] = {1, -1, 0, 0};
+	const int32 DY[4] = {0, 0, 1, -1};
+
+	for (int32 i = 0; i < 4; ++i)
+	{
+		const FIntPoint Neighbor(Tile.X + DX[i], Tile.Y + DY[i]);
+		if (!IsOccupied(Neighbor))
+		{
+			OutNeighbors.Add(Neighbor);
+		}
+	}
+}
+
+void UTileOccupancySubsystem::Deinitialize()
+{
+	Tiles.Reset();
+	Super::Deinitialize();
+}
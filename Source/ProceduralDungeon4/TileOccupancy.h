@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TileOccupancy.generated.h"
+
+//Set of occupied tiles keyed by integer tile coordinates.
+//Answers "is this tile taken?" in O(1) without going through the physics scene
+struct PROCEDURALDUNGEON4_API FTileOccupancyGrid
+{
+	explicit FTileOccupancyGrid(float InTileSize = 100.f)
+		: TileSize(InTileSize)
+	{}
+
+	//Distance between tile centers in world units
+	float TileSize;
+
+	FIntPoint WorldToTile(const FVector& Location) const;
+	FVector TileToWorld(const FIntPoint& Tile, float Z = 0.f) const;
+
+	FORCEINLINE bool IsOccupied(const FIntPoint& Tile) const
+	{
+		return Occupied.Contains(Tile);
+	}
+
+	//Returns false if the tile was already occupied
+	bool Add(const FIntPoint& Tile);
+	void Remove(const FIntPoint& Tile);
+	void Reset();
+
+	int32 Num() const { return Occupied.Num(); }
+
+	//4-connected neighbors (NSWE) of Tile that are free
+	void GetEmptyNeighbors(const FIntPoint& Tile, TArray<FIntPoint>& OutNeighbors) const;
+
+private:
+	TSet<FIntPoint> Occupied;
+};
+
+//World-wide tile occupancy shared by every room generator and room in the world
+UCLASS()
+class PROCEDURALDUNGEON4_API UTileOccupancySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	FTileOccupancyGrid& GetTiles() { return Tiles; }
+	const FTileOccupancyGrid& GetTiles() const { return Tiles; }
+
+	virtual void Deinitialize() override;
+
+private:
+	FTileOccupancyGrid Tiles;
+};
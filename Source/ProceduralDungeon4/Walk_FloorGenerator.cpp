@@ -2,84 +2,107 @@
 
 
 #include "Walk_FloorGenerator.h"
+#include "DungeonAsync.h"
+#include "DungeonMeshing.h"
+#include "DungeonChunkStreamer.h"
+#include "DungeonStats.h"
+#include "DungeonMemory.h"
 #include "Engine/World.h"
 #include "Engine/StaticMeshActor.h"
 #include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
 
 // Sets default values
 AWalk_FloorGenerator::AWalk_FloorGenerator()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = false;
+	Root = CreateDefaultSubobject<USceneComponent>("Root");
+	SetRootComponent(Root);
+
+	ChunkStreamer = CreateDefaultSubobject<UDungeonChunkStreamer>("ChunkStreamer");
 
 }
 
-// Called when the game starts or when spawned
-void AWalk_FloorGenerator::BeginPlay()
+FWalkLayoutSettings AWalk_FloorGenerator::MakeLayoutSettings() const
 {
-	Super::BeginPlay();
-
-	GenerateMap();
-	SpawnGeometry();
-	
+	FWalkLayoutSettings Settings;
+	Settings.MapWidth = MapWidth;
+	Settings.MapHeight = MapHeight;
+	Settings.NumSteps = NumSteps;
+	Settings.bStartInCenter = bStartInCenter;
+	Settings.Seed = DungeonGrid::ResolveSeed(Seed);
+	return Settings;
 }
 
-// Called every frame
-void AWalk_FloorGenerator::Tick(float DeltaTime)
+void AWalk_FloorGenerator::GenerateLayout()
 {
-	Super::Tick(DeltaTime);
+	FWalkLayoutBuilder Builder(MakeLayoutSettings());
+	Builder.GenerateMap();
+	Layout = MoveTemp(Builder.Grid);
+}
 
+void AWalk_FloorGenerator::GenerateLayoutInBackground(TUniqueFunction<void(FDungeonGrid&&)>&& OnBuilt)
+{
+	DungeonAsync::LaunchLayoutTask(this,
+		[Builder = FWalkLayoutBuilder(MakeLayoutSettings())]() mutable
+		{
+			Builder.GenerateMap();
+			return MoveTemp(Builder.Grid);
+		},
+		MoveTemp(OnBuilt));
 }
 
-void AWalk_FloorGenerator::GenerateMap()
+void FWalkLayoutBuilder::GenerateMap()
 {
-	const int32 NumCells = MapWidth * MapHeight;
+	DUNGEON_LLM_SCOPE(Grid);
+	const double StartTime = FPlatformTime::Seconds();
+
+	const int32 NumCells = Settings.MapWidth * Settings.MapHeight;
 	if (NumCells <= 0)
 	{
 		UE_LOG(LogTemp, Warning, TEXT("Walk_FloorGenerator: invalid map size."));
 		return;
 	}
 
-	InitializeMap();
-	RunRandomWalk();
-}
+	//Start with all walls
+	Grid.Init(Settings.MapWidth, Settings.MapHeight, false);
+	Grid.Seed = Settings.Seed;
 
-void AWalk_FloorGenerator::InitializeMap()
-{
-	const int32 NumCells = MapWidth * MapHeight;
-	Map.SetNum(NumCells);
+	FRandomStream Rng(Settings.Seed);
+	RunRandomWalk(Rng);
 
-	//Start with all walls
-	for (int32 i = 0; i < NumCells; ++i)
-	{
-		//Wall
-		Map[i] = true;
-	}
+	//The walk carves straight into Grid, no scratch memory
+	Grid.BuildStats.BuildMs = (float)((FPlatformTime::Seconds() - StartTime) * 1000.0);
 }
 
-void AWalk_FloorGenerator::RunRandomWalk()
+void FWalkLayoutBuilder::RunRandomWalk(FRandomStream& Rng)
 {
+	DUNGEON_SCOPE(RandomWalk);
+	INC_DWORD_STAT_BY(STAT_Dungeon_CellsProcessed, FMath::Max(0, Settings.NumSteps));
+
+	const int32 MapWidth = Settings.MapWidth;
+	const int32 MapHeight = Settings.MapHeight;
+
 	if (MapWidth <= 2 || MapHeight <= 2) return;
 
 	int32 X, Y;
 
-	if (bStartInCenter)
+	if (Settings.bStartInCenter)
 	{
 		X = MapWidth / 2;
 		Y = MapHeight / 2;
 	}
 	else
 	{
-		X = FMath::RandRange(1, MapWidth - 2);
-		Y = FMath::RandRange(1, MapHeight - 2);
+		X = Rng.RandRange(1, MapWidth - 2);
+		Y = Rng.RandRange(1, MapHeight - 2);
 	}
 
 	//Floor
-	Map[Index(X, Y)] = false;
+	Grid.SetFloor(X, Y, true);
 
-	for (int32 Step = 0; Step < NumSteps; ++Step)
+	for (int32 Step = 0; Step < Settings.NumSteps; ++Step)
 	{
-		int32 Dir = FMath::RandRange(0, 3);
+		int32 Dir = Rng.RandRange(0, 3);
 
 		switch(Dir)
 		{
@@ -104,12 +127,17 @@ void AWalk_FloorGenerator::RunRandomWalk()
 		Y = FMath::Clamp(Y, 1, MapHeight - 2);
 
 		//Carve floor
-		Map[Index(X, Y)] = false;
+		Grid.SetFloor(X, Y, true);
 	}
 }
 
 void AWalk_FloorGenerator::SpawnGeometry()
 {
+	DUNGEON_SCOPE(SpawnGeometry);
+	const double SpawnStart = FPlatformTime::Seconds();
+
+	UpdateGenerationDescriptor();
+
 	UWorld* World = GetWorld();
 	if(!World) return;
 
@@ -119,67 +147,75 @@ void AWalk_FloorGenerator::SpawnGeometry()
 		return;
 	}
 
+	ActorPool.BeginReuse();
+
+	//Only one representation of the layout may be alive, drop the other one from an earlier pass
+	if (bStreamChunks)
+	{
+		ActorPool.EndReuse();
+		DungeonMeshing::DestroyChunks(FloorChunks);
+		StartStreaming();
+		RecordTelemetry(SpawnStart);
+		return;
+	}
+
+	ChunkStreamer->ClearLayout();
+
 	const float BasePlaneSize = 100.f;
 
-	for (int32 y = 0; y < MapHeight; ++y)
+	if (bMergeFloorMeshes && FloorMesh)
+	{
+		BuildMergedFloor();
+	}
+	else
+	{
+		//Chunks of an earlier merged pass would draw and collide under the per-cell planes
+		DungeonMeshing::DestroyChunks(FloorChunks);
+	}
+
+	//Gather first, then spawn each mesh in one batch
+	TArray<FTransform> FloorTransforms;
+	TArray<FTransform> WallTransforms;
+
+	for (int32 y = 0; y < Layout.Height; ++y)
 	{
-		for (int32 x = 0; x < MapWidth; ++x)
+		for (int32 x = 0; x < Layout.Width; ++x)
 		{
-			const bool bIsWall = Map[Index(x, y)];
+			const bool bIsWall = !Layout.IsFloor(x, y);
 
 			const FVector CellWorld = GetActorLocation() + FVector(x * TileSize, y * TileSize, 0.f);
 
 			//Floor
-			if (!bIsWall && FloorMesh)
+			if (!bIsWall && FloorMesh && !bMergeFloorMeshes)
 			{
 				const FVector Pos = CellWorld + FVector(0.f, 0.f, FloorZ);
 
-				AStaticMeshActor* FloorActor = World->SpawnActor<AStaticMeshActor>(Pos, FRotator::ZeroRotator);
-				if (!FloorActor) continue;
-
-				UStaticMeshComponent* MeshComp = FloorActor->GetStaticMeshComponent();
-				if(!MeshComp)
-				{
-					FloorActor->Destroy();
-					continue;
-				}
-
-				MeshComp->SetStaticMesh(FloorMesh);
-
 				const float Scale = TileSize / BasePlaneSize;
-				FloorActor->SetActorScale3D(FVector(Scale, Scale, 1.f));
-				FloorActor->SetMobility(EComponentMobility::Static);
+				FloorTransforms.Add(FTransform(FRotator::ZeroRotator, Pos, FVector(Scale, Scale, 1.f)));
 			}
 			//Walls
 			else if (bIsWall && WallMesh)
 			{
-				if(!HasFloorNeighbor(x, y)) continue;
+				if(!HasFloorNeighbor(Layout, x, y)) continue;
 
 				const FVector Pos = CellWorld + FVector(0.f, 0.f, FloorZ + WallHeight * 0.f);
 
-				AStaticMeshActor* WallActor = World->SpawnActor<AStaticMeshActor>(Pos, FRotator::ZeroRotator);
-				if (!WallActor) continue;
-
-				UStaticMeshComponent* MeshComp = WallActor->GetStaticMeshComponent();
-				if (!MeshComp)
-				{
-					WallActor->Destroy();
-					continue;
-				}
-
-				MeshComp->SetStaticMesh(WallMesh);
-
 				const float XYScale = TileSize / BasePlaneSize;
 				const float ZScale = WallHeight / BasePlaneSize;
-				WallActor->SetActorScale3D(FVector(XYScale, XYScale, ZScale));
-				WallActor->SetMobility(EComponentMobility::Static);
+				WallTransforms.Add(FTransform(FRotator::ZeroRotator, Pos, FVector(XYScale, XYScale, ZScale)));
 			}
 		}
 	}
 
+	ActorPool.AcquireBatch(World, FloorMesh, FloorTransforms);
+	ActorPool.AcquireBatch(World, WallMesh, WallTransforms);
+
+	ActorPool.EndReuse();
+
+	RecordTelemetry(SpawnStart);
 }
 
-bool AWalk_FloorGenerator::HasFloorNeighbor(int32 X, int32 Y) const
+bool AWalk_FloorGenerator::HasFloorNeighbor(const FDungeonGrid& Grid, int32 X, int32 Y)
 {
 	//4-connected neighbors NSWE
 	const int32 DX[4] = {1, -1, 0, 0};
@@ -190,17 +226,94 @@ bool AWalk_FloorGenerator::HasFloorNeighbor(int32 X, int32 Y) const
 		int32 NX = X + DX[i];
 		int32 NY = Y + DY[i];
 
-		if (NX < 0 || NY < 0 || NX >= MapWidth || NY >= MapHeight)
+		if (Grid.IsFloor(NX, NY))
 		{
-			continue;
+			return true;
 		}
+	}
 
-		//false = floor
-		if (!Map[Index(NX, NY)])
+	return false;
+}
+
+void AWalk_FloorGenerator::BuildMergedFloor()
+{
+	DUNGEON_LLM_SCOPE(Actors);
+	DUNGEON_SCOPE(BuildMergedFloor);
+
+	//Cells are centered on their coordinates, so cell (0,0) starts half a tile back
+	const FVector CellOrigin(-TileSize * 0.5f, -TileSize * 0.5f, FloorZ);
+
+	DungeonMeshing::BuildFloorChunks(this, Root, Layout, FloorChunkSize, TileSize, CellOrigin,
+		FloorMesh ? FloorMesh->GetMaterial(0) : nullptr, FloorChunks);
+}
+
+void AWalk_FloorGenerator::StartStreaming()
+{
+	const FVector CellOrigin(-TileSize * 0.5f, -TileSize * 0.5f, FloorZ);
+
+	ChunkStreamer->SetLayout(Layout, Root, TileSize, CellOrigin,
+		FloorMesh ? FloorMesh->GetMaterial(0) : nullptr, WallMesh,
+		[this](const FDungeonGrid& Grid, const FIntRect& CellRect, const FIntPoint& CellOffset, TArray<FTransform>& OutTransforms)
 		{
-			return true;
+			GatherWallTransforms(Grid, CellRect, CellOffset, OutTransforms);
+		});
+}
+
+void AWalk_FloorGenerator::GatherWallTransforms(const FDungeonGrid& Grid, const FIntRect& CellRect, const FIntPoint& CellOffset, TArray<FTransform>& OutTransforms) const
+{
+	const float BasePlaneSize = 100.f;
+	const FVector WallScale(TileSize / BasePlaneSize, TileSize / BasePlaneSize, WallHeight / BasePlaneSize);
+
+	for (int32 y = CellRect.Min.Y; y < CellRect.Max.Y; ++y)
+	{
+		for (int32 x = CellRect.Min.X; x < CellRect.Max.X; ++x)
+		{
+			if (Grid.IsFloor(x, y) || !HasFloorNeighbor(Grid, x, y)) continue;
+
+			const FIntPoint Cell = CellOffset + FIntPoint(x, y);
+			OutTransforms.Add(FTransform(FRotator::ZeroRotator, FVector(Cell.X * TileSize, Cell.Y * TileSize, FloorZ), WallScale));
 		}
 	}
+}
 
-	return false;
-}
\ No newline at end of file
+bool AWalk_FloorGenerator::PrepareBake()
+{
+	//Streamed geometry lives in pooled components that come and go with the player
+	if (bStreamChunks)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Walk_FloorGenerator: streamed layouts can't be baked, turn off bStreamChunks"));
+		return false;
+	}
+
+	//Merged chunks are procedural meshes, which can't hold lightmaps. Bake per-cell floor actors instead
+	bMergeFloorMeshes = false;
+	return true;
+}
+
+FDungeonSeedSearchResult AWalk_FloorGenerator::SearchSeeds(const FDungeonSeedConstraints& Constraints, int32 NumSeeds, int32 NumBest, int32 FirstSeed) const
+{
+	return DungeonSeedSearch::SearchBuilder(GetGeneratorName(), MakeLayoutSettings(), &FWalkLayoutBuilder::GenerateMap, FirstSeed, NumSeeds, NumBest, Constraints);
+}
+
+void AWalk_FloorGenerator::UpdateGenerationDescriptor()
+{
+	DungeonReplication::UpdateDescriptor(this, bReplicateGeneration, GetGeneratorName(), MakeLayoutSettings(), Layout, GenerationDescriptor);
+}
+
+void AWalk_FloorGenerator::ApplyGenerationDescriptor()
+{
+	FWalkLayoutSettings Settings;
+	if (!DungeonReplication::ReadSettings(GenerationDescriptor, GetGeneratorName(), Settings)) return;
+
+	DungeonReplication::BuildFromDescriptor(this, GenerationDescriptor, Settings, &FWalkLayoutBuilder::GenerateMap, bGenerateAsync, OnLayoutReady,
+		[this](FWalkLayoutBuilder& Builder)
+		{
+			SpawnLayout(Builder.Grid);
+		});
+}
+
+void AWalk_FloorGenerator::AddTelemetryDetails(FDungeonGenerationTelemetry& Telemetry) const
+{
+	Telemetry.Parameters = FString::Printf(TEXT("NumSteps=%d StartInCenter=%d"), NumSteps, bStartInCenter ? 1 : 0);
+	Telemetry.MeshChunks = FloorChunks.Num();
+}
@@ -3,11 +3,56 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
+#include "DungeonFloorGeneratorBase.h"
 #include "Walk_FloorGenerator.generated.h"
 
+class UProceduralMeshComponent;
+class UDungeonChunkStreamer;
+
+//Parameters of the logical phase, copied out of the actor before generation
+USTRUCT(BlueprintType)
+struct FWalkLayoutSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Walker")
+	int32 MapWidth = 60;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Walker")
+	int32 MapHeight = 40;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Walker")
+	int32 NumSteps = 1000;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Walker")
+	bool bStartInCenter = true;
+
+	//Already resolved, never negative
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Walker")
+	int32 Seed = 0;
+};
+
+//Logical phase of AWalk_FloorGenerator. Touches no UObjects, so it is safe to run on a worker thread
+struct FWalkLayoutBuilder
+{
+	explicit FWalkLayoutBuilder(const FWalkLayoutSettings& InSettings)
+		: Settings(InSettings)
+	{}
+
+	//Fills Grid
+	void GenerateMap();
+
+	FWalkLayoutSettings Settings;
+
+	//Result - true = floor, false = wall
+	FDungeonGrid Grid;
+
+private:
+	void RunRandomWalk(FRandomStream& Rng);
+};
+
 UCLASS()
-class PROCEDURALDUNGEON4_API AWalk_FloorGenerator : public AActor
+class PROCEDURALDUNGEON4_API AWalk_FloorGenerator : public ADungeonFloorGeneratorBase
 {
 	GENERATED_BODY()
 	
@@ -16,9 +61,6 @@ public:
 	AWalk_FloorGenerator();
 
 protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-
 	//Grid Size
     UPROPERTY(EditAnywhere, Category = "Walker")
 	int32 MapWidth = 60;
@@ -38,14 +80,6 @@ protected:
     UPROPERTY(EditAnywhere, Category = "Walker")
 	float TileSize = 100.f;
 
-	//Mesh to use for floor cells
-    UPROPERTY(EditAnywhere, Category = "Walker")
-	UStaticMesh* FloorMesh;
-
-	//Wall mesh
-    UPROPERTY(EditAnywhere, Category = "Walker")
-	UStaticMesh* WallMesh;
-
 	//Height offsets
     UPROPERTY(EditAnywhere, Category = "Walker")
 	float FloorZ = 0.f;
@@ -53,24 +87,60 @@ protected:
     UPROPERTY(EditAnywhere, Category = "Walker")
 	float WallHeight = 200.f;	
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	// ---- Floor Meshing ----
 
-private:
-	//true = wall, false= floor
-	TArray<bool> Map;
+	//Merge floor cells into rectangles per chunk and draw each chunk as one procedural mesh
+	//instead of one plane actor per cell. Uses FloorMesh's material
+	UPROPERTY(EditAnywhere, Category = "Floor Meshing")
+	bool bMergeFloorMeshes = true;
 
-	FORCEINLINE int32 Index(int32 X, int32 Y) const
-	{
-		return Y * MapWidth + X;
-	};
+	//Chunk size in cells
+	UPROPERTY(EditAnywhere, Category = "Floor Meshing", meta = (EditCondition = "bMergeFloorMeshes", ClampMin = "1"))
+	int32 FloorChunkSize = 32;
 
-	void GenerateMap();
-	void InitializeMap();
-	void RunRandomWalk();
-	void SpawnGeometry();
+	UPROPERTY(VisibleAnywhere, Category = "Components")
+	TObjectPtr<USceneComponent> Root;
+
+	//One merged floor mesh per chunk
+	UPROPERTY()
+	TArray<TObjectPtr<UProceduralMeshComponent>> FloorChunks;
+
+	//bMergeFloorMeshes path, replaces the per-cell floor planes
+	void BuildMergedFloor();
+
+	// ---- Streaming ----
+
+	//Hand the layout to ChunkStreamer instead of spawning it all at once. Only chunks around
+	//the player get geometry: merged floors and instanced walls, from pooled components
+	UPROPERTY(EditAnywhere, Category = "Streaming")
+	bool bStreamChunks = false;
+
+	UPROPERTY(VisibleAnywhere, Category = "Components")
+	TObjectPtr<UDungeonChunkStreamer> ChunkStreamer;
+
+	void StartStreaming();
+
+	//Same walls SpawnGeometry would place, for the cells of Grid in CellRect. See UDungeonChunkStreamer::FGatherWallsFunc
+	void GatherWallTransforms(const FDungeonGrid& Grid, const FIntRect& CellRect, const FIntPoint& CellOffset, TArray<FTransform>& OutTransforms) const;
+
+	// ---- Builder hooks ----
+
+	virtual const TCHAR* GetGeneratorName() const override { return TEXT("Walk"); }
+	virtual void GenerateLayout() override;
+	virtual void GenerateLayoutInBackground(TUniqueFunction<void(FDungeonGrid&&)>&& OnBuilt) override;
+	virtual void UpdateGenerationDescriptor() override;
+	virtual void ApplyGenerationDescriptor() override;
+	virtual FDungeonSeedSearchResult SearchSeeds(const FDungeonSeedConstraints& Constraints, int32 NumSeeds, int32 NumBest, int32 FirstSeed) const override;
+	virtual void SpawnGeometry() override;
+	virtual void AddTelemetryDetails(FDungeonGenerationTelemetry& Telemetry) const override;
+
+	//Streamed layouts can't be baked, merged floors are baked as per-cell actors
+	virtual bool PrepareBake() override;
+
+private:
+	//Snapshot of the config above with the seed resolved
+	FWalkLayoutSettings MakeLayoutSettings() const;
 
-	bool HasFloorNeighbor(int32 X, int32 Y) const;
+	static bool HasFloorNeighbor(const FDungeonGrid& Grid, int32 X, int32 Y);
 
 };